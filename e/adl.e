@@ -0,0 +1,20 @@
+#ifndef ADL
+#define ADL
+
+/************************** ADL.E ******************************
+*
+*  The externals declaration file for the Active Delay List
+*    Module of the support level.
+*
+*  Written by Gavin Kyte and Ploy Sithisakulrat
+****************************************************************/
+
+#include "../h/types.h"
+
+extern void initADL ();
+extern Bool insertDelay (int asid, cpu_t wakeTime);
+extern int removeExpired (cpu_t now);
+
+/***************************************************************/
+
+#endif
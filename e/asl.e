@@ -15,6 +15,10 @@ extern int insertBlocked (int *semAdd, pcb_PTR p);
 extern pcb_PTR removeBlocked (int *semAdd);
 extern pcb_PTR outBlocked (pcb_PTR p);
 extern pcb_PTR headBlocked (int *semAdd);
+extern int insertBlockedSorted (int *semAdd, pcb_PTR p, int key);
+extern pcb_PTR removeAllBlocked (int *semAdd);
+extern int insertWaitNode (int *semAdd, waitnode_PTR w);
+extern waitnode_PTR outWaitNode (waitnode_PTR w);
 extern void initASL ();
 
 /***************************************************************/
@@ -0,0 +1,20 @@
+#ifndef AVSL
+#define AVSL
+
+/************************** AVSL.E *****************************
+*
+*  The externals declaration file for the Active Virtual
+*    Semaphore List Module of the support level.
+*
+*  Written by Gavin Kyte and Ploy Sithisakulrat
+****************************************************************/
+
+#include "../h/types.h"
+
+extern void initAVSL ();
+extern Bool insertVirtBlocked (int *semAdd, int asid);
+extern int removeVirtBlocked (int *semAdd);
+
+/***************************************************************/
+
+#endif
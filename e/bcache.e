@@ -0,0 +1,28 @@
+#ifndef BCACHE
+#define BCACHE
+
+/************************ BCACHE.E *****************************
+*
+*  The externals declaration file for the support level's disk
+*    block cache Module.
+*
+*  Written by Gavin Kyte and Ploy Sithisakulrat
+****************************************************************/
+
+#include "../h/types.h"
+
+extern void initBCache (memaddr base);
+extern bcache_PTR lookupBlock (int disk, int sector);
+extern bcache_PTR lruBlock ();
+extern void setBlock (bcache_PTR b, int disk, int sector);
+extern void dropBlock (bcache_PTR b);
+extern void touchBlock (bcache_PTR b);
+extern int dirtyBlocks (int disk, bcache_PTR blocks[]);
+extern void writeStarted (int disk);
+extern void writeDone (int disk);
+extern int writeGen (int disk);
+extern Bool writesQuiet (int disk, int gen);
+
+/***************************************************************/
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef DISKQ
+#define DISKQ
+
+/************************* DISKQ.E *****************************
+*
+*  The externals declaration file for the support level's disk
+*    request queue Module.
+*
+*  Written by Gavin Kyte and Ploy Sithisakulrat
+****************************************************************/
+
+#include "../h/types.h"
+
+extern void initDiskQ ();
+extern void insertDiskReq (int disk, diskreq_PTR req);
+extern diskreq_PTR removeNextReq (int disk, int fromSector);
+extern diskreq_PTR removeSameRead (int disk, diskreq_PTR served);
+
+/***************************************************************/
+
+#endif
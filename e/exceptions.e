@@ -22,6 +22,8 @@ extern void copyState(state_PTR orig, state_PTR dest);
 extern void sysCallHandler();
 extern void tlbHandler();
 extern void pgrmTrapHandler();
+extern void wakeWaitAny(pcb_PTR p);
+extern int ringCount(pcb_PTR p);
 
 /***************************************************************/
 
@@ -0,0 +1,23 @@
+#ifndef INFOPAGE
+#define INFOPAGE
+
+/************************** INFOPAGE.E **************************
+*
+*  The externals declaration file for the info page library.
+*
+*  Linked into processes, not the nucleus: reads the time and
+*  the caller's CPU time off the kernel info page (kinfo_t)
+*  without a SYSCALL.
+*
+*  Written by Gavin Kyte and Ploy Sithisakulrat
+****************************************************************/
+
+#include "../h/types.h"
+
+extern kinfo_PTR infoPage();
+extern cpu_t infoTOD(kinfo_PTR k);
+extern cpu_t infoCPUTime(kinfo_PTR k);
+
+/***************************************************************/
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef INITPROC
+#define INITPROC
+
+/************************* INITPROC.E **************************
+*
+*  The externals declaration file for the support level's
+*  instantiator, which sets up virtual memory, starts a U-proc
+*  per tape, the delay daemon and a daemon per disk, and owns
+*  the support level's global data.
+*
+*  Written by Gavin Kyte and Ploy Sithisakulrat
+****************************************************************/
+
+#include "../h/types.h"
+
+extern uproc_t uProcs[MAXUPROC];
+extern pteOS_t ksegOSPte;
+extern pteUser_t kUseg3Pte;
+extern swap_t swapPool[SWAPPOOLSIZE];
+extern memaddr swapPoolBase;
+extern memaddr dmaBufBase;
+extern swapext_t swapExtents[MAXUPROC + 1];
+extern int diskCyl[DEVPERINT];
+extern diskstat_t diskStats[DEVPERINT];
+extern cachestat_t cacheStats;
+extern termring_t txRings[DEVPERINT];
+extern termring_t rxRings[DEVPERINT];
+extern spool_t spools[DEVPERINT];
+
+extern int swapSem;
+extern int masterSem;
+extern int adlSem;
+extern int avslSem;
+extern int devMutex[DEVSEMNUM];
+extern int diskWork[DEVPERINT];
+extern int cacheSem;
+extern int cacheWait;
+extern int cacheWaiters;
+extern int pinSem;
+extern int pinMutex;
+
+extern void test();
+
+/***************************************************************/
+
+#endif
@@ -17,6 +17,12 @@
 
 extern Bool waiting;
 extern cpu_t startTOD;
+extern cpu_t bootTOD;
+extern cpu_t idleTime;
+extern cpu_t interTime;
+extern cpu_t nextTickTOD;
+extern clockstat_t clockStats;
+extern kinfo_t kernInfo;
 extern int procCount;
 extern int softBlkCount;
 
@@ -25,8 +31,12 @@ extern pcb_PTR deathRowLine;
 
 extern int *psuedoClock;
 extern int semaphores[MAXSEMS];
+extern iostat_t ioStats[DEVSEMNUM];
+extern pcb_PTR ringOwner[DEVSEMNUM];
+extern unsigned int devStatus[DEVSEMNUM];
 
 extern int* findSem(int lineNum, int deviceNum, Bool isReadTerm);
+extern void logLatency(int hist[], cpu_t elapsed);
 
 /***************************************************************/
 
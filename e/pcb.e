@@ -13,7 +13,9 @@
 
 extern void freePcb (pcb_PTR p);
 extern pcb_PTR allocPcb ();
+extern pcb_PTR allocPcbs (int n);
 extern void initPCBs ();
+extern pcb_PTR findPid (int pid);
 
 extern pcb_PTR mkEmptyProcQ ();
 extern int emptyProcQ (pcb_PTR tp);
@@ -21,9 +23,11 @@ extern void insertProcQ (pcb_PTR *tp, pcb_PTR p);
 extern pcb_PTR removeProcQ (pcb_PTR *tp);
 extern pcb_PTR outProcQ (pcb_PTR *tp, pcb_PTR p);
 extern pcb_PTR headProcQ (pcb_PTR tp);
+extern void mergeProcQ (pcb_PTR *tp, pcb_PTR q);
 
 extern int emptyChild (pcb_PTR p);
 extern void insertChild (pcb_PTR prnt, pcb_PTR p);
+extern void insertChildren (pcb_PTR prnt, pcb_PTR q);
 extern pcb_PTR removeChild (pcb_PTR p);
 extern pcb_PTR outChild (pcb_PTR p);
 
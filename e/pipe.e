@@ -0,0 +1,27 @@
+#ifndef PIPE
+#define PIPE
+
+/**************************** PIPE.E ****************************
+*
+*  The externals declaration file for the nucleus Pipe module.
+*
+*  Pipes are fixed-size byte rings in kernel memory; the module
+*  owns the table and the byte copying, the SYSCALLs that block
+*  on a pipe's sema4s live in exceptions.
+*
+*  Written by Gavin Kyte and Ploy Sithisakulrat
+****************************************************************/
+
+#include "../h/types.h"
+
+extern void initPipes();
+extern pipe_PTR allocPipe();
+extern void freePipe(pipe_PTR pp);
+extern pipe_PTR findPipe(int id);
+extern int pipeId(pipe_PTR pp);
+extern int pipeIn(pipe_PTR pp, char* buf, int n);
+extern int pipeOut(pipe_PTR pp, char* buf, int n);
+
+/***************************************************************/
+
+#endif
@@ -13,8 +13,10 @@
 
 extern void putInPool(pcb_PTR p);
 extern void loadState(state_PTR state);
+extern void chargeCurProc(Bool isSysCall);
 extern void gameOver(int fileOrigin);
 extern void nextVictim();
+extern void handOff(pcb_PTR p);
 
 /***************************************************************/
 
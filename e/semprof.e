@@ -0,0 +1,28 @@
+#ifndef SEMPROF
+#define SEMPROF
+
+/************************** SEMPROF.E **************************
+*
+*  The externals declaration file for the Semaphore Profiler
+*  module.
+*
+*  The profiler tracks P counts, contended P's, time blocked
+*  and queue length per semaphore address so the nucleus can
+*  report which sema4s cause the most blocking.
+*
+*  Written by Gavin Kyte and Ploy Sithisakulrat
+****************************************************************/
+
+#include "../h/types.h"
+
+extern int semProfDropped;
+
+extern void initSemProf();
+extern void profP(int* semAdd);
+extern void profV(int* semAdd);
+extern void profWake(pcb_PTR p, cpu_t wakeTOD);
+extern int topSemProfiles(semprof_PTR top, int n);
+
+/***************************************************************/
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef VMIOSUPPORT
+#define VMIOSUPPORT
+
+/************************ VMIOSUPPORT.E ************************
+*
+*  The externals declaration file for the support level's
+*  exception handlers: the pager, the program trap handler and
+*  the SYS9-SYS24 services, plus the delay, disk, flusher,
+*  terminal & printer daemons and the device I/O helpers they
+*  share with the instantiator.
+*
+*  Written by Gavin Kyte and Ploy Sithisakulrat
+****************************************************************/
+
+#include "../h/types.h"
+
+extern void vmTlbHandler();
+extern void vmPgmHandler();
+extern void vmSysHandler();
+extern void killUProc(int asid);
+extern void delayDaemon();
+extern void diskDaemon(int disk);
+extern void cacheFlusher();
+extern void termTxDaemon(int term);
+extern void termRxDaemon(int term);
+extern void printDaemon(int prnt);
+extern device_t* devReg(int lineNum, int deviceNum);
+extern unsigned int doIO(unsigned int* cmdReg, unsigned int cmd,
+	int lineNum, int deviceNum, Bool isReadTerm);
+extern int diskRequest(int disk, int sector, memaddr buf, int cmd);
+extern int flushCache(int disk);
+extern int backingSector(int owner, int page);
+extern void reportVM();
+
+/***************************************************************/
+
+#endif
@@ -47,6 +47,73 @@
 #define WAITCLOCK				7
 #define WAITIO					8
 
+/* Extended nucleus system calls; SYS9-SYS39 belong to the support level */
+#define GETCPUTIMES				40
+#define GETSYSTIMES				41
+#define GETCLOCKSTATS			42
+#define GETIOSTATS				43
+#define GETSEMPROFILE			44
+#define BATCHOPS				45
+#define IORINGSETUP				46
+#define IOBIND					47
+#define IOWAITANY				48
+#define WAITANY					49
+#define BARRIERINIT				50
+#define BARRIERWAIT				51
+#define ECAWAIT					52
+#define ECADVANCE				53
+#define SEQTICKET				54
+#define SEND					55
+#define RECV					56
+#define CALL					57
+#define REPLY					58
+#define GETPID					59
+#define PIPECREATE				60
+#define PIPEWRITE				61
+#define PIPEREAD				62
+#define PIPEDESTROY				63
+#define GETINFOPAGE				64
+#define TERMINATEPID			65
+#define GETPROCINFO				66
+#define EXITPROCESS				67
+#define JOIN					68
+#define SPAWNMANY				69
+#define PIPECLOSE				70
+#define LASTNUCSYSCALL			PIPECLOSE
+
+/* BATCHOPS operation codes besides VERHOGEN, PASSEREN & GETCPUTIME */
+#define BROADCASTV		0	/* release every process blocked on the sema4 */
+#define BATCHBADOP		-1	/* b_result of an unknown operation */
+#define BATCHWOULDBLOCK	-2	/* b_result of a P that would have blocked */
+
+/* BARRIERWAIT results */
+#define BARRIERWAITER	0	/* released by another process's arrival */
+#define BARRIERLAST		1	/* the arrival that completed the round */
+
+#define ANYSENDER		0	/* RECV from whoever SENDs or CALLs first */
+
+/*
+ * PIDs: the pcb's slot in the pcb table in the low PIDSLOTBITS, the
+ * slot's generation above them; always > 0, so never ANYSENDER
+ */
+#define NOPID			-1
+#define PIDSLOTBITS		8
+#define PIDSLOTMASK		((1 << PIDSLOTBITS) - 1)
+#define MAXPIDGEN		((1 << (31 - PIDSLOTBITS)) - 1)
+
+/* JOIN: any child, and the exit codes of processes that did not exit */
+#define ANYCHILD		0
+#define EXITNORMAL		0	/* TERMINATEPROCESS */
+#define EXITKILLED		-1	/* ended by TERMINATEPID or an ancestor */
+#define EXITTRAPPED		-2	/* killed by an exception it did not handle */
+
+/* GETPROCINFO states */
+#define PROCRUNNING		0
+#define PROCREADY		1
+#define PROCBLOCKED		2
+
+#define SEMPROFILING	TRUE /* FALSE turns the semaphore profiler off */
+
 /* utility constants */
 #define TRUE		1
 #define FALSE		0
@@ -56,6 +123,8 @@
 #define NEW		1
 #define CHILD		0
 #define NOCHILD	-1
+#define SUCCESS	0
+#define FAILURE	-1
 #define HIDDEN		static
 #define Bool		int
 #define EOS		'\0'
@@ -95,6 +164,9 @@
 #define PRNTINT		6
 #define TERMINT		7
 
+#define NOIOSLOT	-1	/* pcb is not waiting on or woken from a device */
+#define IOHISTBASE	128	/* μ seconds covered by the first latency bucket */
+
 #define DEVREGLEN	4	/* device register field length in bytes & regs per dev */
 #define DEVREGSIZE	16	/* device register size in bytes */
 
@@ -119,10 +191,114 @@
 #define RESET		0
 #define ACK			1
 
+/* device specific COMMAND & STATUS codes used by the support level */
+#define DISKSEEK		2
+#define DISKREAD		3
+#define DISKWRITE		4
+#define TAPEREAD		3
+#define PRINTCHAR		2
+#define TRANSMITCHAR	2
+#define RECEIVECHAR		2
+#define CHARRECEIVED	5
+#define CHARTRANSMITTED	5
+#define DISKSEEKERR		4
+#define DEVSTATUSMASK	0xFF
+#define TERMCHARSHIFT	8	/* char position in terminal commands & status */
+
+/* disk DATA1 geometry and command operands */
+#define DISKCYLSHIFT	16
+#define DISKHEADSHIFT	8
+#define DISKFIELDMASK	0xFF
+#define SEEKCYLSHIFT	8
+#define BLKHEADSHIFT	16
+#define BLKSECTSHIFT	8
+
+/* tape DATA1 block markers */
+#define TAPEEOT		0
+#define TAPEEOF		1
+#define TAPEEOB		2
+#define TAPETS		3
+
+/****************************************************************************
+ * Support level (phase 3)
+ ****************************************************************************/
+
+/* SYS9-SYS24, the U-proc services */
+#define READTERMINAL	9
+#define WRITETERMINAL	10
+#define VSEMVIRT		11
+#define PSEMVIRT		12
+#define DELAY			13
+#define DISK_PUT		14
+#define DISK_GET		15
+#define WRITEPRINTER	16
+#define GET_TOD			17
+#define TERMINATE		18
+#define DISK_FLUSH		19
+#define DISK_GETV		20
+#define DISK_PUTV		21
+#define DRAINTERMINAL	22
+#define WAITPRINTJOB	23
+#define DISK_STATS		24
+
+#define NOASID			-1
+#define SHAREDASID		0	/* "owner" of the shared kUseg3 pages */
+#define MAXASID			64
+#define ASIDSHIFT		6
+#define ASIDMASK		(0x3F << ASIDSHIFT)
+#define VPNSHIFT		12
+#define VPNMASK			0xFFFFF000
+#define SECOND			1000000	/* μ seconds */
+
+/* segments & page tables; ksegOS is identity mapped */
+#define SEGTBLADDR		0x20000500	/* [MAXASID] x {ksegOS, kUseg2, kUseg3} */
+#define KUSEG2ADDR		0x80000000
+#define KUSEG3ADDR		0xC0000000
+#define KUSEG2PAGES		(KUSEGPTESIZE - 1)	/* text & data, then the stack */
+#define STACKPAGE		(KUSEGPTESIZE - 1)	/* kUseg2 PT index of the stack */
+#define STACKVPN		0xBFFFF
+#define UPROCSTART		0x800000B0	/* entry point of an a.out image */
+#define UPROCSTACK		KUSEG3ADDR	/* top of the kUseg2 stack page */
+
+/*
+ * entryLO; the low byte is ignored by the hardware and used by the pager.
+ * PTEDIRTY is the hardware's write enable; user pages are loaded without
+ * it, so the first store takes a TLB-Modification and marks them dirty.
+ */
+#define PTEDIRTY		(1 << 10)
+#define PTEVALID		(1 << 9)
+#define PTEGLOBAL		(1 << 8)
+#define PTERESIDENT		(1 << 1)	/* the PFN still holds the page */
+#define PTEONDISK		(1 << 0)	/* the backing store has a copy */
+#define PFNMASK			0xFFFFF000
+
+/* Cause.ExcCode of the exceptions tlbHandler passes up */
+#define EXCCODE(C)		(((C) >> 2) & 0x1F)
+#define TLBMODCODE		1	/* store to a valid page whose D bit is off */
+#define TLBLCODE		2	/* TLB-Invalid on a load or fetch */
+#define TLBSCODE		3	/* TLB-Invalid on a store */
+
+#define SWAPPOOLSIZE	(2 * MAXUPROC)	/* frames */
+#define NOFRAME			-1
+#define RAMAXWINDOW		4	/* most pages read ahead of a sequential fault */
+#define BACKINGDISK		0	/* disk0 holds the swap space */
+#define SEEKAWARESWAP	TRUE /* FALSE interleaves swap as page * owners + owner */
+#define BCACHESIZE		8	/* DISK_GET/DISK_PUT cache buffers, a page each */
+#define BCACHEHASH		16	/* power of 2; hash buckets of the cache index */
+#define NODISK			-1
+#define FLUSHTICKS		10	/* pseudo-clock ticks between flusher passes */
+#define MAXDISKVEC		8	/* segments of one DISK_GETV/DISK_PUTV */
+#define MAXPINNED		(SWAPPOOLSIZE / 2)	/* frames pinned at once, >= MAXDISKVEC */
+
 /* operations */
 #define	MIN(A,B)	((A) < (B) ? A : B)
 #define MAX(A,B)	((A) < (B) ? B : A)
 #define	ALIGNED(A)	(((unsigned)A & 0x3) == 0)
+#define PAGEALIGNED(A)	(((unsigned)A & (PAGESIZE - 1)) == 0)
+
+/* Index of a device's sema4 in semaphores[] (and its iostat_t) */
+#define DEVSEMINDEX(LINE, DEV, ISREADTERM) \
+	((((LINE) - LINENUMOFFSET) + ((ISREADTERM) ? 1 : 0)) * DEVPERINT + (DEV))
 
 /* Useful operations */
 /* Accesses time of day clock at that moment, this TOD clock has no interrupt */
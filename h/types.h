@@ -85,7 +85,34 @@ typedef struct state_t {
 #define s_HI	s_reg[29]
 #define s_LO	s_reg[30]
 
-#define MAXPROC	20
+/*
+ * ASL wait node: links one waiting process into one semaphore's queue.
+ * Each pcb owns MAXWAITANY of them so WAITANY can queue it on several
+ * sema4s at once; p_waits[0] also serves ordinary P's.
+ */
+#define MAXWAITANY	8
+typedef struct waitnode_t {
+	struct waitnode_t	*w_next,	/* next node on the same sema4 */
+						*w_prev;	/* previous node on the same sema4 */
+	struct pcb_t		*w_pcb;		/* the waiting process */
+	int					*w_semAdd;	/* sema4 queued on, NULL if none */
+	int					w_key;		/* sort key, see insertBlockedSorted */
+} waitnode_t, *waitnode_PTR;
+
+/* Exit of a child not yet collected by its parent's JOIN */
+#define MAXEXITRECS	8 /* beyond this the oldest exits are forgotten */
+typedef struct exitrec_t {
+	int		e_pid;
+	int		e_code;		/* as passed to EXITPROCESS, or EXIT* */
+} exitrec_t;
+
+/*
+ * Enough pcbs for the support level at its largest: test, the delay &
+ * flusher daemons, a daemon per disk, two per terminal and one per
+ * printer, and a U-proc per tape
+ */
+#define MAXUPROC	8	/* one per tape, ASIDs 1..MAXUPROC */
+#define MAXPROC		(3 + 4 * DEVPERINT + MAXUPROC)
 typedef struct pcb_t {
 	/* process queue fields */
 	struct pcb_t	*p_next,	/* pointer to next entry */
@@ -103,15 +130,396 @@ typedef struct pcb_t {
 	state_t 	p_s;		/* processor state */
 	int 			*p_semAdd;	/* ptr to sema4 where pcb blocked */
 	unsigned int p_CPUTime; /* total exec time in μ seconds */
+	unsigned int p_kernTime; /* portion of p_CPUTime spent in SYSCALLs */
+
+	/* WAITIO latency tracking, see iostat_t */
+	int			p_ioSlot;	/* device sema4 index, NOIOSLOT if none */
+	cpu_t		p_ioTOD;	/* when it blocked, then when the I/O completed */
+	cpu_t		p_blockTOD;	/* when it last blocked on p_semAdd */
+
+	struct ioring_t	*p_ioRing;	/* async I/O completion ring, or NULL */
+	int			p_ioTail;	/* the ring's r_tail, as the nucleus left it */
+
+	/* ASL queue links, see waitnode_t */
+	waitnode_t	p_waits[MAXWAITANY];
+	int			p_waitCount;	/* sema4s of a pending WAITANY, else 0 */
+	int			p_waitSoft;		/* TRUE if one of them is a nucleus sema4 */
+
+	int			p_pid;		/* see findPid; NOPID while free */
+	int			p_pidGen;	/* generation of its slot, kept across reuse */
+
+	/* JOIN; exits of its children, oldest first */
+	exitrec_t	p_exits[MAXEXITRECS];
+	int			p_exitCount;
+	int			p_joinSem;	/* address it blocks on in JOIN */
+	int			p_joinPid;	/* child a pending JOIN waits for */
+
+	/* IPC; only the addresses of these are used, as ASL keys */
+	int			p_ipcRecv;		/* it waits here in RECV */
+	int			p_ipcSenders;	/* SEND/CALLers wait here for its RECV */
+	int			p_ipcCallers;	/* CALLers wait here for its REPLY */
+	int			p_ipcRecvers;	/* RECVs naming it wait here for its SEND */
+	int			p_ipcFrom;		/* sender a pending RECV accepts, else NOPID */
 } pcb_t, *pcb_PTR;
 
+/* Per-process CPU time breakdown filled in by GETCPUTIMES */
+typedef struct cputime_t {
+	cpu_t	c_user;		/* time executing its own instructions */
+	cpu_t	c_kernel;	/* time the nucleus spent servicing its SYSCALLs */
+	cpu_t	c_total;	/* c_user + c_kernel, what GETCPUTIME reports */
+} cputime_t, *cputime_PTR;
+
+/* System-wide utilization snapshot filled in by GETSYSTIMES */
+typedef struct systime_t {
+	cpu_t	st_total;	/* wall time since the nucleus booted */
+	cpu_t	st_idle;	/* time WAITing with an empty ready queue */
+	cpu_t	st_inter;	/* time in intHandler, charged to no process */
+} systime_t, *systime_PTR;
+
+/* Pseudo-clock tick timing; jitter is how late a tick fired (μ seconds) */
+typedef struct clockstat_t {
+	int		ck_ticks;		/* interval interrupts taken */
+	int		ck_missed;		/* deadlines that passed before re-arming */
+	cpu_t	ck_minJitter;
+	cpu_t	ck_maxJitter;
+	cpu_t	ck_avgJitter;	/* kept up to date by each tick */
+	cpu_t	ck_sumJitter;
+} clockstat_t, *clockstat_PTR;
+
 /* We use 49 sem's; 32normal + 2*8terminal (r/w) + 1timer */
 #define MAXSEMS 49
+#define DEVSEMNUM (MAXSEMS - 1) /* device sema4s precede the psuedo-clock */
+
+/*
+ * Per device sema4 WAITIO statistics, indexed like findSem.
+ * Service time runs from the WAITIO block to the completion interrupt;
+ * wakeup delay runs from the completion to the process being dispatched.
+ * Histogram bucket i counts times below (IOHISTBASE << i) μ seconds,
+ * the last bucket counts everything slower.
+ */
+#define IOHISTBUCKETS 10
+typedef struct iostat_t {
+	int		io_count;		/* completed WAITIOs */
+	int		io_maxWaiters;	/* most processes ever blocked at once */
+	cpu_t	io_sumService;
+	cpu_t	io_maxService;
+	cpu_t	io_sumWakeup;
+	cpu_t	io_maxWakeup;
+	int		io_serviceHist[IOHISTBUCKETS];
+	int		io_wakeupHist[IOHISTBUCKETS];
+} iostat_t, *iostat_PTR;
+
+/*
+ * Async I/O completion ring living in the owning process's memory.
+ * The nucleus appends at r_tail from intHandler, the process consumes
+ * at r_head; the ring is empty when they meet and holds at most
+ * IORINGSIZE - 1 entries. Completions arriving at a full ring are
+ * counted in r_dropped.
+ *
+ * The process may scribble on the ring, so the nucleus keeps its own
+ * tail (p_ioTail) and only ever writes r_tail, never indexes by it; an
+ * r_head outside [0, IORINGSIZE) makes the ring count as full.
+ */
+#define IORINGSIZE 16
+typedef struct iocomp_t {
+	int				c_line;		/* interrupt line of the device */
+	int				c_dev;		/* device number on that line */
+	int				c_isRead;	/* TRUE for a terminal receive */
+	unsigned int	c_status;	/* device status, as WAITIO returns */
+	cpu_t			c_tod;		/* when the completion was taken */
+} iocomp_t;
+
+typedef struct ioring_t {
+	int			r_head;		/* next entry to consume (process) */
+	int			r_tail;		/* next entry to fill (nucleus) */
+	int			r_dropped;	/* completions lost to a full ring */
+	iocomp_t	r_entries[IORINGSIZE];
+} ioring_t, *ioring_PTR;
+
+/* One operation of a BATCHOPS request */
+typedef struct batchop_t {
+	int		b_op;		/* VERHOGEN, PASSEREN, BROADCASTV or GETCPUTIME */
+	int		b_arg;		/* semaphore address for the sema4 ops */
+	int		b_result;	/* filled in by the nucleus, see sys45 */
+} batchop_t, *batchop_PTR;
+
+/*
+ * Barrier for b_parties processes, living in user memory. b_remaining
+ * counts down the arrivals still missing and doubles as the address the
+ * early arrivals block on; b_round counts completed rounds.
+ */
+typedef struct barrier_t {
+	int		b_parties;
+	int		b_remaining;
+	int		b_round;
+} barrier_t, *barrier_PTR;
+
+/*
+ * Eventcount (Reed & Kanodia), living in user memory. ec_value only
+ * grows; ec_waiters is minus the number of processes blocked in ECAWAIT,
+ * like a sema4's value, and is the address they block on.
+ */
+typedef struct eventcount_t {
+	int		ec_value;
+	int		ec_waiters;
+} eventcount_t, *eventcount_PTR;
+
+/* Sequencer handing out consecutive tickets for use with an eventcount */
+typedef struct sequencer_t {
+	int		sq_next;	/* next ticket to hand out */
+} sequencer_t, *sequencer_PTR;
+
+/* Message of a synchronous SEND or CALL, as RECV stores it */
+typedef struct msg_t {
+	int		m_w0;	/* a2 of the sender */
+	int		m_w1;	/* a3 of the sender */
+} msg_t, *msg_PTR;
+
+/*
+ * Nucleus pipe: a byte ring in kernel memory, see pipe.c. The sema4s
+ * count minus the processes blocked reading or writing, and are what
+ * they block on in the ASL.
+ */
+#define MAXPIPES		8
+#define PIPESIZE		512
+#define PIPEWATERMARK	(PIPESIZE / 2) /* bytes that wake a reader early */
+typedef struct pipe_t {
+	int		pp_inUse;	/* TRUE once created, until destroyed */
+	int		pp_head;	/* next byte to read */
+	int		pp_count;	/* bytes in the ring */
+	int		pp_closed;	/* TRUE once PIPECLOSEd; no more writes */
+	int		pp_readSem;
+	int		pp_writeSem;
+	char	pp_buf[PIPESIZE];
+} pipe_t, *pipe_PTR;
+
+/*
+ * Kernel info page, refreshed by loadState each time a process is
+ * (re)started; GETINFOPAGE gives its address, see infopage.c.
+ * Read-only to processes. ki_gen is odd while an update is under way
+ * and changes with every update, so a reader retries on a mismatch.
+ */
+typedef struct kinfo_t {
+	int		ki_gen;
+	cpu_t	ki_timeScale;	/* TOD ticks per μ second */
+	cpu_t	ki_TOD;			/* TOD snapshot, when the running process resumed */
+	cpu_t	ki_CPUTime;		/* its p_CPUTime as of ki_TOD */
+} kinfo_t, *kinfo_PTR;
+
+/* Snapshot of another process filled in by GETPROCINFO */
+typedef struct procinfo_t {
+	int		pi_pid;
+	int		pi_parent;		/* PID of its parent, NOPID for the root */
+	int		pi_state;		/* PROCRUNNING, PROCREADY or PROCBLOCKED */
+	cpu_t	pi_CPUTime;		/* as GETCPUTIME would report to it */
+	cpu_t	pi_kernTime;
+} procinfo_t, *procinfo_PTR;
+
+/*
+ * Support level (phase 3)
+ *
+ * Page table entry, in the format the uMPS2 TLB refill searches.
+ * See the PTE* bits in const.h for entryLO.
+ */
+typedef struct pte_t {
+	unsigned int	pte_entryHI;	/* VPN and ASID */
+	unsigned int	pte_entryLO;	/* PFN and flags */
+} pte_t, *pte_PTR;
+
+/* Page tables; the header is PTEMAGICNO << 24 | the number of entries */
+#define KSEGOSPTESIZE	128	/* ksegOS frames mapped, RAM is at most this */
+#define KUSEGPTESIZE	32
+typedef struct pteOS_t {
+	unsigned int	pt_header;
+	pte_t			pt_entries[KSEGOSPTESIZE];
+} pteOS_t;
+
+typedef struct pteUser_t {
+	unsigned int	pt_header;
+	pte_t			pt_entries[KUSEGPTESIZE];
+} pteUser_t;
+
+/* One ASID's row of the segment table at SEGTBLADDR */
+typedef struct segTbl_t {
+	pteOS_t		*st_ksegOS;
+	pteUser_t	*st_kUseg2;
+	pteUser_t	*st_kUseg3;
+} segTbl_t;
+
+/* Swap pool frame; see the pager in vmIOsupport.c */
+typedef struct swap_t {
+	int		sw_asid;	/* owner, SHAREDASID for kUseg3, NOASID if free */
+	int		sw_page;	/* index of the page in its owner's page table */
+	pte_t	*sw_pte;	/* the entry mapping this frame */
+	int		sw_ref;		/* TRUE if referenced since the clock last passed */
+	int		sw_prefetch;	/* TRUE if read ahead and not touched yet */
+	int		sw_pinned;	/* disk transfers in progress to or from it */
+} swap_t;
+
+/*
+ * Swap space of one owner (SHAREDASID or a U-proc): se_pages sectors of
+ * the backing store from se_start, one per page table entry
+ */
+typedef struct swapext_t {
+	int		se_start;
+	int		se_pages;
+} swapext_t;
+
+/* Pager counters of one U-proc */
+typedef struct vmstat_t {
+	int		vm_faults;		/* faults that had to fill a frame */
+	int		vm_softFaults;	/* faults on a page still in its frame */
+	int		vm_pageIns;		/* backing store reads */
+	int		vm_pageOuts;	/* backing store writes */
+	int		vm_cleanDrops;	/* victims reused without a write-back */
+	int		vm_raPages;		/* pages read ahead */
+	int		vm_raHits;		/* of those, touched before being evicted */
+	cpu_t	vm_inTime;		/* μ seconds spent in backing store reads */
+} vmstat_t, *vmstat_PTR;
+
+/* Support level state of one U-proc, uProcs[ASID - 1] */
+typedef struct uproc_t {
+	int			u_sem;		/* private sema4, for DELAY and PSEMVIRT */
+	pteUser_t	u_pte;		/* its kUseg2 page table */
+	vmstat_t	u_stats;
+	int			u_lastFault;	/* kUseg2 page of its last fault or hit */
+	int			u_raWindow;		/* pages to read ahead of the next fault */
+	state_t		u_oldTrap[3];	/* SPECTRAPVEC areas, by TLBTRAP..SYSTRAP */
+	state_t		u_newTrap[3];
+} uproc_t, *uproc_PTR;
+
+/*
+ * Disk request, queued by diskSubmit and served by the disk's daemon,
+ * see diskq.c. It lives on the requester's stack; the requester waits
+ * on r_done.
+ */
+typedef struct diskreq_t {
+	struct diskreq_t	*r_next;
+	int					r_sector;	/* linear sector number */
+	memaddr				r_buf;		/* physical page to transfer */
+	int					r_cmd;		/* DISKREAD or DISKWRITE */
+	int					r_status;	/* as diskIO returns, once served */
+	int					r_done;		/* sema4, V'ed once served */
+	cpu_t				r_queued;	/* TOD it was submitted */
+} diskreq_t, *diskreq_PTR;
+
+/* One segment of a DISK_GETV/DISK_PUTV vector, in the U-proc's memory */
+typedef struct diskvec_t {
+	memaddr	dv_buf;		/* its page */
+	int		dv_sector;	/* linear sector number */
+	int		dv_status;	/* set to READY, or minus the failed status */
+} diskvec_t;
+
+/*
+ * Character ring of one terminal, see vmIOsupport.c. On transmit,
+ * WRITETERMINAL fills it and the terminal's transmit daemon drains it;
+ * on receive, the receive daemon fills it and READTERMINAL drains it.
+ * The sema4s are waited on by whoever raised the matching flag or count.
+ */
+#define TERMRINGSIZE	256
+typedef struct termring_t {
+	char	tr_buf[TERMRINGSIZE];
+	int		tr_head;		/* oldest character */
+	int		tr_count;		/* characters held, incl. one being transmitted */
+	int		tr_lines;		/* newlines held, receive only */
+	int		tr_status;		/* READY, or minus the first failed status */
+	int		tr_idle;		/* TRUE while the daemon waits on tr_work */
+	int		tr_work;		/* for characters to send, or room to receive */
+	int		tr_writers;		/* writers waiting on tr_space, transmit only */
+	int		tr_space;
+	int		tr_waiters;		/* waiting on tr_event: DRAINTERMINALs for the */
+	int		tr_event;		/* ring to empty, READTERMINALs for a line */
+} termring_t;
+
+/*
+ * Spool of one printer, see vmIOsupport.c. WRITEPRINTER queues a job's
+ * characters on sp_buf and its length on sp_jobLen; the printer's
+ * daemon prints them, counting each job down. Jobs are numbered from 1
+ * per printer, in the order spooled.
+ */
+#define SPOOLSIZE		512
+#define SPOOLJOBS		16
+typedef struct spool_t {
+	char	sp_buf[SPOOLSIZE];
+	int		sp_head;		/* oldest character */
+	int		sp_count;		/* characters held, incl. one being printed */
+	int		sp_jobLen[SPOOLJOBS];	/* characters left per job, oldest first */
+	int		sp_jobHead;
+	int		sp_jobs;		/* jobs queued, incl. the one printing */
+	int		sp_lastJob;		/* id of the newest job spooled */
+	int		sp_doneJob;		/* id of the newest job printed */
+	int		sp_status;		/* READY, or minus the first failed status */
+	int		sp_idle;		/* TRUE while the daemon waits on sp_work */
+	int		sp_work;
+	int		sp_writers;		/* writers waiting on sp_space, for room or a job */
+	int		sp_space;
+	int		sp_waiters;		/* WAITPRINTJOBs waiting on sp_event */
+	int		sp_event;
+} spool_t;
+
+/* Disk scheduler counters of one disk */
+typedef struct diskstat_t {
+	int		ds_requests;	/* requests served */
+	int		ds_merged;		/* of those, reads served by another's transfer */
+	int		ds_seeks;		/* DISKSEEKs issued */
+	cpu_t	ds_sumLatency;	/* μ seconds from submission to completion */
+	cpu_t	ds_maxLatency;
+	cpu_t	ds_busy;		/* μ seconds the daemon spent transferring */
+} diskstat_t;
+
+/*
+ * Block cache buffer, see bcache.c; holds sector b_sector of disk b_disk
+ * in the physical page b_buf, NODISK if it holds none
+ */
+typedef struct bcache_t {
+	struct bcache_t	*b_hnext;	/* hash chain */
+	struct bcache_t	*b_prev;	/* LRU list, most recently used first */
+	struct bcache_t	*b_next;
+	int				b_disk;
+	int				b_sector;
+	memaddr			b_buf;
+	int				b_dirty;	/* TRUE if newer than the sector on disk */
+	int				b_busy;		/* TRUE while a transfer owns b_buf */
+} bcache_t, *bcache_PTR;
+
+/* Block cache counters, over every disk */
+typedef struct cachestat_t {
+	int		cs_hits;		/* DISK_GETs served by a copy alone */
+	int		cs_misses;		/* DISK_GETs that read the disk */
+	int		cs_puts;		/* DISK_PUTs absorbed by the cache */
+	int		cs_writeBacks;	/* dirty buffers written to their disk */
+} cachestat_t;
+
+/* Active delay list entry, see adl.c */
+typedef struct delayd_t {
+	struct delayd_t	*d_next;
+	cpu_t			d_wakeTime;	/* TOD the sleeper is due at */
+	int				d_asid;
+} delayd_t, *delayd_PTR;
+
+/* Active virtual semaphore list entry, see avsl.c */
+typedef struct avsd_t {
+	struct avsd_t	*v_next;
+	int				*v_semAdd;	/* kUseg3 semaphore P'ed on */
+	int				v_asid;
+} avsd_t, *avsd_PTR;
+
+/* Contention profile of one semaphore address, see semprof.c */
+#define SEMPROFSIZE 64 /* power of 2; bound on sema4s profiled */
+typedef struct semprof_t {
+	int		*sp_semAdd;		/* NULL for an unused entry */
+	int		sp_pCount;		/* P's, incl. WAITCLOCK & WAITIO */
+	int		sp_contended;	/* P's that blocked */
+	int		sp_vCount;
+	cpu_t	sp_sumBlocked;	/* total μ seconds processes spent blocked */
+	cpu_t	sp_maxBlocked;
+	int		sp_maxQueue;	/* most processes blocked at once */
+} semprof_t, *semprof_PTR;
 typedef struct semd_t {
 /* semaphore descriptor type */
 	struct semd_t	*s_next;		/* next element on the ASL */
 	int				*s_semAdd;		/* pointer to the semaphore */
-	pcb_t			*s_procQ;		/* tail pointer to a process queue */
+	waitnode_t		*s_procQ;		/* tail pointer to a wait node queue */
 } semd_t, *semd_PTR;
 
 #endif
@@ -4,6 +4,11 @@
  * The ASL is maintained as a priority queue sorted on semd_PTR->s_semAdd
  * with two dummy nodes at 0 and MAXINT for boundary condition simplicity.
  *
+ * Each semd queues wait nodes rather than ProcBlks, managed like the
+ * process queues: circular, doubly linked with a tail pointer. A ProcBlk
+ * owns several wait nodes, so it can be blocked on more than one
+ * semaphore at a time (see WAITANY); ordinary P's use its first node.
+ *
  * The free list is kept as a singley linked stack, order is not-important.
  *
  * AUTHORS: Gavin Kyte & Ploy Sithisakulrat
@@ -52,12 +57,96 @@ HIDDEN semd_PTR allocSemd (void) {
 
 		/* Clean semd */
 		gift->s_next = NULL;
-		gift->s_procQ = mkEmptyProcQ();
+		gift->s_procQ = NULL;
 		gift->s_semAdd = NULL;
 		return (gift);
 	}
 }
 
+/*
+ * insertWaitQ - a mutator to append wait node w at the tail of the
+ *		wait queue whose tail pointer is pointed to by tp.
+ */
+HIDDEN void insertWaitQ (waitnode_PTR *tp, waitnode_PTR w) {
+	if((*tp) == NULL) {
+		w->w_next = w;
+		w->w_prev = w;
+	} else {
+		/* link w between tail and head */
+		w->w_next = (*tp)->w_next;
+		w->w_prev = (*tp);
+		(*tp)->w_next = w;
+		w->w_next->w_prev = w;
+	}
+	(*tp) = w;
+}
+
+/*
+ * outWaitQ - a mutator to unlink wait node w, known to be on the wait
+ *		queue whose tail pointer is pointed to by tp, in constant time.
+ */
+HIDDEN void outWaitQ (waitnode_PTR *tp, waitnode_PTR w) {
+	if(w->w_next == w) {
+		/* Last node in queue */
+		(*tp) = NULL;
+	} else {
+		w->w_prev->w_next = w->w_next;
+		w->w_next->w_prev = w->w_prev;
+		if((*tp) == w) {
+			(*tp) = w->w_prev;
+		}
+	}
+
+	w->w_next = NULL;
+	w->w_prev = NULL;
+	w->w_semAdd = NULL; /* no longer queued anywhere */
+}
+
+/*
+ * dequeueWait - a mutator to unlink wait node w from the semd following
+ *		predecessor, freeing the semd when its queue empties.
+ * RETURN:	the ProcBlk that owned w.
+ */
+HIDDEN pcb_PTR dequeueWait (semd_PTR predecessor, waitnode_PTR w) {
+	semd_PTR target = predecessor->s_next;
+
+	outWaitQ(&(target->s_procQ), w);
+
+	/* When the queue is empty, we clear up the semd */
+	if(target->s_procQ == NULL) {
+		predecessor->s_next = target->s_next;
+		freeSemd(target);
+	}
+
+	return (w->w_pcb);
+}
+
+/*
+ * insertWaitQSorted - a mutator to insert wait node w into the wait
+ *		queue whose tail pointer is pointed to by tp, ahead of the first
+ *		node with a greater w_key; equal keys stay in FIFO order.
+ */
+HIDDEN void insertWaitQSorted (waitnode_PTR *tp, waitnode_PTR w) {
+	waitnode_PTR nomad;
+
+	if((*tp) == NULL || (*tp)->w_key <= w->w_key) {
+		/* Belongs at the tail */
+		insertWaitQ(tp, w);
+		return;
+	}
+
+	nomad = (*tp)->w_next;
+	while(nomad->w_key <= w->w_key) {
+		nomad = nomad->w_next;
+	}
+
+	/* link w just before nomad; the tail is unchanged */
+	w->w_next = nomad;
+	w->w_prev = nomad->w_prev;
+	nomad->w_prev->w_next = w;
+	nomad->w_prev = w;
+}
+
 /*
  * searchSemd - an accessor used to find and return the predecessor/proper
  *		location of the desired semaphore, regardless of whether it exists yet.
@@ -74,6 +163,30 @@ HIDDEN semd_PTR searchSemd (int *semAdd) {
 	return (nomad);
 }
 
+/*
+ * findSemd - a mutator to return the semd for semAdd, allocating and
+ *		linking a new one into the ASL if it is not active yet.
+ * RETURN:	the semd; NULL if one was needed and the free list is empty.
+ */
+HIDDEN semd_PTR findSemd (int *semAdd) {
+	semd_PTR predecessor = searchSemd(semAdd);
+	semd_PTR target;
+
+	if(predecessor->s_next->s_semAdd == semAdd) {
+		return (predecessor->s_next);
+	}
+
+	target = allocSemd();
+	if(target != NULL) {
+		/* Init fields and insert new semd into ASL */
+		target->s_procQ = NULL;
+		target->s_semAdd = semAdd;
+		target->s_next = predecessor->s_next;
+		predecessor->s_next = target;
+	}
+	return (target);
+}
+
 /******************** External methods ***********************/
 /*
  * insertBlocked - a mutator to insert the ProcBlk at the tail of the process
@@ -86,30 +199,65 @@ HIDDEN semd_PTR searchSemd (int *semAdd) {
  *		the free list is empty. Otherwise, return FALSE
  */
 int insertBlocked (int *semAdd, pcb_PTR p) {
-	semd_PTR predecessor = searchSemd(semAdd);
-	semd_PTR target; /* object to insert p into */
+	p->p_waits[0].w_pcb = p;
+	if(insertWaitNode(semAdd, &(p->p_waits[0]))) {
+		return (TRUE);
+	}
 
-	/* Verify if sema4 already in place or needs allocated
-	 * If a new semaphore descriptor needs to be allocated and the semdFree
-	 * list is empty, return TRUE, otherwise return FALSE. */
-	if(predecessor->s_next->s_semAdd == semAdd) {
-		target = predecessor->s_next;
-	} else {
-		target = allocSemd();
-		if(target == NULL) {
-			/* Allocation failed, empty free list */
-			return (TRUE);
-		} else {
-			/* Init fields and insert new semd into ASL */
-			target->s_procQ = mkEmptyProcQ();
-			target->s_semAdd = semAdd;
-			target->s_next = predecessor->s_next;
-			predecessor->s_next = target;
-		}
+	p->p_semAdd = semAdd;
+	return (FALSE);
+}
+
+/*
+ * insertWaitNode - a mutator to queue wait node w, with key 0, on the
+ *		queue associated with semAdd: at the tail of an ordinary queue,
+ *		where every key is 0, and ahead of the waiters with a real key
+ *		on an ECAWAIT queue, so ECADVANCE finds it at the head. Unlike
+ *		insertBlocked it leaves w->w_pcb's p_semAdd alone, so the owner
+ *		may hold several nodes.
+ *
+ * PARAM:	*semAdd - a pointer to a semaphore address
+ *		w - a wait node not currently queued, its w_pcb already set
+ * RETURN:	TRUE if a new semaphore descriptor needs to be allocated and
+ *		the free list is empty. Otherwise, return FALSE
+ */
+int insertWaitNode (int *semAdd, waitnode_PTR w) {
+	semd_PTR target = findSemd(semAdd); /* object to insert w into */
+
+	if(target == NULL) {
+		/* Allocation failed, empty free list */
+		return (TRUE);
+	}
+
+	w->w_semAdd = semAdd;
+	w->w_key = 0;
+	insertWaitQSorted(&(target->s_procQ), w);
+	return (FALSE);
+}
+
+/*
+ * insertBlockedSorted - a mutator like insertBlocked, except that p is
+ *		queued in ascending order of key instead of at the tail, so the
+ *		head is always the waiter with the smallest key (see ECAWAIT).
+ *
+ * PARAM:	*semAdd - a pointer to a semaphore address
+ *		p - a pointer to a process block to be inserted to process queue
+ *		key - p's sort key, kept in its wait node's w_key
+ * RETURN:	TRUE if a new semaphore descriptor needs to be allocated and
+ *		the free list is empty. Otherwise, return FALSE
+ */
+int insertBlockedSorted (int *semAdd, pcb_PTR p, int key) {
+	semd_PTR target = findSemd(semAdd);
+
+	if(target == NULL) {
+		return (TRUE);
 	}
 
+	p->p_waits[0].w_pcb = p;
+	p->p_waits[0].w_semAdd = semAdd;
+	p->p_waits[0].w_key = key;
+	insertWaitQSorted(&(target->s_procQ), &(p->p_waits[0]));
 	p->p_semAdd = semAdd;
-	insertProcQ(&(target->s_procQ), p);
 	return (FALSE);
 }
 
@@ -122,6 +270,9 @@ int insertBlocked (int *semAdd, pcb_PTR p) {
  * If the process queue for this semaphore becomes empty, remove the semaphore
  * descriptor from the ASL and return it to the semdFree list.
  *
+ * The ProcBlk's p_semAdd is left naming semAdd, which tells a WAITANY
+ * caller which of its semaphores fired.
+ *
  * PARAM:		*semAdd - a pointer to a semaphore address
  * RETURN: 	a head pointer to a removed ProcBlc from the process queue
  *		of the found semaphore; NULL if the semaphore is not found.
@@ -130,21 +281,55 @@ pcb_PTR removeBlocked (int *semAdd) {
 	pcb_PTR result;
 	semd_PTR predecessor = searchSemd(semAdd);
 	if(predecessor->s_next->s_semAdd == semAdd) {
-		semd_PTR target = predecessor->s_next;
-
-		result = removeProcQ(&(target->s_procQ)); /* This should NOT be NULL */
-		/* When ProcQ is empty, we clear up the semd */
-		if(emptyProcQ(target->s_procQ)) {
-			predecessor->s_next = target->s_next;
-			freeSemd(target);
-		}
-
+		/* Head of the queue follows the tail; this should NOT be NULL */
+		result = dequeueWait(predecessor, predecessor->s_next->s_procQ->w_next);
+		result->p_semAdd = semAdd;
 		return (result);
 	} else {
 		return (NULL);
 	}
 }
 
+/*
+ * removeAllBlocked - a mutator to remove every ProcBlk blocked on semAdd
+ *		at once, returning the semd to the free list after one search.
+ *
+ * The ProcBlks keep their order and p_semAdd, as with removeBlocked.
+ *
+ * PARAM:		*semAdd - a pointer to a semaphore address
+ * RETURN:	tail pointer to a process queue of the removed ProcBlks, to
+ *		be spliced whole with mergeProcQ; empty if semAdd is not found.
+ */
+pcb_PTR removeAllBlocked (int *semAdd) {
+	semd_PTR predecessor = searchSemd(semAdd);
+	semd_PTR target = predecessor->s_next;
+	waitnode_PTR w, next;
+	pcb_PTR released = mkEmptyProcQ();
+
+	if(target->s_semAdd != semAdd) {
+		return (released);
+	}
+
+	/* Unhook the whole queue and free the semd */
+	w = target->s_procQ->w_next;
+	target->s_procQ->w_next = NULL;
+	predecessor->s_next = target->s_next;
+	freeSemd(target);
+
+	while(w != NULL) {
+		next = w->w_next;
+		w->w_next = NULL;
+		w->w_prev = NULL;
+		w->w_semAdd = NULL;
+
+		w->w_pcb->p_semAdd = semAdd;
+		insertProcQ(&released, w->w_pcb);
+		w = next;
+	}
+
+	return (released);
+}
+
 /*
  * outBlocked - a mutator to remove the ProcBlk pointed to by p from the
  *		process queue associated with p’s semaphore (p→ p semAdd) on the ASL.
@@ -153,28 +338,42 @@ pcb_PTR removeBlocked (int *semAdd) {
  * does not appear in the process queue associated with p’s semaphore,
  * which is an error condition, return NULL; otherwise, return p.
  *
+ * Only the ordinary wait is removed; a WAITANY's nodes go through
+ * outWaitNode one by one.
+ *
  * PARAM:		p - a process block in a process queue associated with its
  *		semaphore on the active list.
  * RETURN:	p if found; otherwise, return NULL (error)
  */
 pcb_PTR outBlocked (pcb_PTR p) {
-	pcb_PTR shouldBeP;
-	semd_PTR predecessor = searchSemd(p->p_semAdd);
+	if(p->p_waits[0].w_semAdd != p->p_semAdd) {
+		/* p is not queued on its semaphore (anymore) */
+		return (NULL);
+	}
 
-	if(predecessor->s_next->s_semAdd == p->p_semAdd) {
-		semd_PTR target = predecessor->s_next;
-		shouldBeP = outProcQ( &(target->s_procQ), p);
+	return (outWaitNode(&(p->p_waits[0])) == NULL ? NULL : p);
+}
 
-		/* When ProcQ is empty, we clear up the semd */
-		if(emptyProcQ(target->s_procQ)) {
-			predecessor->s_next = target->s_next;
-			freeSemd(target);
-		}
+/*
+ * outWaitNode - a mutator to remove wait node w from the queue of the
+ *		semaphore it is queued on, freeing the semd if it empties.
+ *
+ * PARAM:		w - a wait node
+ * RETURN:	w if it was queued; otherwise, return NULL (error)
+ */
+waitnode_PTR outWaitNode (waitnode_PTR w) {
+	semd_PTR predecessor;
+
+	if(w->w_semAdd == NULL) {
+		return (NULL);
+	}
 
-		/* Yay. Return outProcQ result successfully or report error w/ NULL */
-		return shouldBeP;
+	predecessor = searchSemd(w->w_semAdd);
+	if(predecessor->s_next->s_semAdd == w->w_semAdd) {
+		dequeueWait(predecessor, w);
+		return (w);
 	} else {
-		/* p's associated semd is missing from ASL */
+		/* w's associated semd is missing from ASL */
 		return (NULL);
 	}
 }
@@ -192,8 +391,9 @@ pcb_PTR outBlocked (pcb_PTR p) {
 pcb_PTR headBlocked (int *semAdd) {
 	semd_PTR predecessor = searchSemd(semAdd);
 
-	if(predecessor->s_next->s_semAdd == semAdd) {
-		return (headProcQ(predecessor->s_next->s_procQ));
+	if(predecessor->s_next->s_semAdd == semAdd &&
+			predecessor->s_next->s_procQ != NULL) {
+		return (predecessor->s_next->s_procQ->w_next->w_pcb);
 	} else {
 		return (NULL);
 	}
@@ -23,6 +23,7 @@
 #include "../e/pcb.e"
 
 pcb_PTR pcbFree_h; /* head pointer to the pcbFree list */
+HIDDEN pcb_t procTable[MAXPROC]; /* every pcb; findPid indexes it */
 
 /******************************************************************
  *
@@ -39,15 +40,66 @@ pcb_PTR pcbFree_h; /* head pointer to the pcbFree list */
  * PARAM:	p - a pcb pointer to be added to the pcbFree list.
  */
 void freePcb (pcb_PTR p) {
+	p->p_pid = NOPID; /* handles to p go stale now */
 	insertProcQ(&pcbFree_h, p);
 }
 
+/*
+ * resetPcb - a mutator to give every field of p, bar its processor
+ * state and its queue links, its initial value (i.e. NULL and/or 0),
+ * and p a new PID.
+ */
+HIDDEN void resetPcb (pcb_PTR p) {
+	int i;
+	waitnode_PTR w;
+
+	p->p_pidGen = (p->p_pidGen % MAXPIDGEN) + 1;
+	p->p_pid = (p->p_pidGen << PIDSLOTBITS) | (p - procTable);
+	p->p_CPUTime = 0;
+	p->p_kernTime = 0;
+	p->p_ioSlot = NOIOSLOT;
+	p->p_ioTOD = 0;
+	p->p_blockTOD = 0;
+	p->p_ioRing = NULL;
+	p->p_ioTail = 0;
+	p->p_waitCount = 0;
+	p->p_waitSoft = FALSE;
+	p->p_ipcRecv = 0;
+	p->p_ipcSenders = 0;
+	p->p_ipcCallers = 0;
+	p->p_ipcRecvers = 0;
+	p->p_ipcFrom = NOPID;
+	p->p_exitCount = 0;
+	p->p_joinSem = 0;
+	p->p_joinPid = ANYCHILD;
+	for(i = 0; i < MAXWAITANY; i++) {
+		w = &(p->p_waits[i]);
+		w->w_next = NULL;
+		w->w_prev = NULL;
+		w->w_pcb = p;
+		w->w_semAdd = NULL;
+		w->w_key = 0;
+	}
+	p->p_prnt = NULL;
+	p->p_child = NULL;
+	p->p_old = NULL;
+	p->p_yng = NULL;
+	p->p_semAdd = NULL;
+	p->p_exceptionConfig[OLD][TLBTRAP] = NULL;
+	p->p_exceptionConfig[OLD][PROGTRAP] = NULL;
+	p->p_exceptionConfig[OLD][SYSTRAP] = NULL;
+	p->p_exceptionConfig[NEW][TLBTRAP] = NULL;
+	p->p_exceptionConfig[NEW][PROGTRAP] = NULL;
+	p->p_exceptionConfig[NEW][SYSTRAP] = NULL;
+}
+
 /*
  * allocPcb - a mutator to remove an element from the pcbFree list,
  * provide initial values for ALL of the pcbs' fields
  * (i.e. NULL and/or 0) and then return a pointer to the removed
  * element. Pcbs get reused, so it is important that no previous
  * value persist in a pcb when it gets reallocated.
+ * The exception is the slot generation, bumped for the new PID.
  *
  * RETURN: 	NULL if the pcbFree list is empty; otherwise,
  * 		return a pointer to the removed element from
@@ -71,41 +123,87 @@ pcb_PTR allocPcb (void) {
 			i++;
 		}
 
-		gift->p_CPUTime = 0;
+		resetPcb(gift);
 		gift->p_next = NULL;
 		gift->p_prev= NULL;
-		gift->p_prnt = NULL;
-		gift->p_child = NULL;
-		gift->p_old = NULL;
-		gift->p_yng = NULL;
-		gift->p_semAdd = NULL;
-		gift->p_exceptionConfig[OLD][TLBTRAP] = NULL;
-		gift->p_exceptionConfig[OLD][PROGTRAP] = NULL;
-		gift->p_exceptionConfig[OLD][SYSTRAP] = NULL;
-		gift->p_exceptionConfig[NEW][TLBTRAP] = NULL;
-		gift->p_exceptionConfig[NEW][PROGTRAP] = NULL;
-		gift->p_exceptionConfig[NEW][SYSTRAP] = NULL;
 	}
 	return (gift);
 }
 
+/*
+ * allocPcbs - a mutator to take up to n elements off the pcbFree
+ * list at once, cut off as one run, initialized like allocPcb except
+ * for their processor state, which the caller is to set.
+ *
+ * PARAM:	n - the number of pcbs wanted.
+ * RETURN:	tail pointer to a process queue of the pcbs taken; fewer
+ *		than n (possibly none) if the pcbFree list ran out.
+ */
+pcb_PTR allocPcbs (int n) {
+	pcb_PTR head, last;
+	int taken;
+
+	if(emptyProcQ(pcbFree_h) || n < 1) {
+		return (mkEmptyProcQ());
+	}
+
+	/* Find the end of the run */
+	head = pcbFree_h->p_next;
+	last = head;
+	resetPcb(last);
+	for(taken = 1; taken < n && last != pcbFree_h; taken++) {
+		last = last->p_next;
+		resetPcb(last);
+	}
+
+	if(last == pcbFree_h) {
+		/* Took them all */
+		pcbFree_h = mkEmptyProcQ();
+	} else {
+		/* Close the free list over the gap, then the run on itself */
+		pcbFree_h->p_next = last->p_next;
+		last->p_next->p_prev = pcbFree_h;
+		last->p_next = head;
+		head->p_prev = last;
+	}
+
+	return (last);
+}
+
 /*
  * initPCBs - initialize the pcbFree list to contain all the
  * elements of the static array of MAXPROC pcbs. This method
  * will be called only once during data structure initialization.
  */
 void initPCBs (void) {
-	static pcb_t procTable[MAXPROC];
 	int i = 0;
 
 	pcbFree_h = mkEmptyProcQ(); /* Init pcbFree list */
 
 	while(i < MAXPROC) {
+		procTable[i].p_pidGen = 0;
 		freePcb(&(procTable[i]));
 		i++;
 	}
 }
 
+/*
+ * findPid - an accessor to map a PID to its pcb in constant time:
+ * the slot is in the PID's low bits, and a PID whose pcb has been
+ * freed (or reallocated, with a new generation) no longer matches.
+ *
+ * PARAM:	pid - a PID as handed out by allocPcb.
+ * RETURN:	the live pcb with that PID; NULL if there is none.
+ */
+pcb_PTR findPid (int pid) {
+	int slot = pid & PIDSLOTMASK;
+
+	if(pid <= 0 || slot >= MAXPROC || procTable[slot].p_pid != pid) {
+		return (NULL);
+	}
+	return (&(procTable[slot]));
+}
+
 /*****************************************************************
  *
  * Queue Management; queues managed as circular, doubly linked
@@ -254,6 +352,34 @@ pcb_PTR headProcQ (pcb_PTR tp) {
 	}
 }
 
+/*
+ * mergeProcQ - a mutator method to append the whole process queue
+ * whose tail pointer is q to the process queue whose tail pointer is
+ * pointed to by tp, in constant time. q must not be used afterwards.
+ *
+ * PARAM:	*tp - tail pointer to the process queue to grow.
+ * 		q - tail pointer to the process queue to append.
+ */
+void mergeProcQ (pcb_PTR *tp, pcb_PTR q) {
+	pcb_PTR head;
+
+	if(emptyProcQ(q)) {
+		return;
+	} else if(emptyProcQ(*tp)) {
+		(*tp) = q;
+	} else {
+		/* splice q between tail and head of tp */
+		head = (*tp)->p_next;
+		(*tp)->p_next = q->p_next;
+		q->p_next->p_prev = (*tp);
+		q->p_next = head;
+		head->p_prev = q;
+
+		/* update tp */
+		(*tp) = q;
+	}
+}
+
 
 /***********************************************************************
  *
@@ -294,6 +420,43 @@ void insertChild (pcb_PTR prnt, pcb_PTR p) {
 	}
 }
 
+/*
+ * insertChildren - a mutator to make every ProcBlk on the process
+ * queue whose tail pointer is q a child of prnt, as insertChild
+ * would one by one; the run is hooked onto prnt's children once.
+ *
+ * PARAM:	prnt - a parent node.
+ * 		q - tail pointer to a process queue, left intact.
+ */
+void insertChildren (pcb_PTR prnt, pcb_PTR q) {
+	pcb_PTR p, older;
+
+	if(emptyProcQ(q)) {
+		return;
+	}
+
+	/* Chain the run, oldest (head) to youngest (tail) */
+	p = q->p_next;
+	p->p_old = prnt->p_child;
+	while(TRUE) {
+		p->p_prnt = prnt;
+		if(p == q) {
+			break;
+		}
+		older = p;
+		p = p->p_next;
+		p->p_old = older;
+		older->p_yng = p;
+	}
+	q->p_yng = NULL; /* Border control */
+
+	/* Single splice onto the existing children */
+	if(!emptyChild(prnt)) {
+		prnt->p_child->p_yng = q->p_next;
+	}
+	prnt->p_child = q;
+}
+
 /*
  * removeChild - a mutator method to make the first child of the
  * ProcBlk pointed to by prnt no longer a child of prnt.
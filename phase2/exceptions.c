@@ -22,6 +22,8 @@
 #include "../e/asl.e"
 #include "../e/initial.e"
 #include "../e/scheduler.e"
+#include "../e/semprof.e"
+#include "../e/pipe.e"
 #include "/usr/local/include/umps2/umps/libumps.e"
 
 /************************* Prototypes ************************/
@@ -29,18 +31,60 @@ void copyState(state_PTR orig, state_PTR dest);
 void pgrmTrapHandler();
 void tlbHandler();
 void sysCallHandler();
+int ringCount(pcb_PTR p);
 
-HIDDEN void avadaKedavra(pcb_PTR p);
+HIDDEN void avadaKedavra(pcb_PTR p, int exitCode);
+HIDDEN void reportExit(pcb_PTR parent, int pid, int exitCode);
 HIDDEN void blockCurProc(int* semAdd);
+HIDDEN void parkCurProc();
+HIDDEN void cancelWaits(pcb_PTR p, Bool undoNucleus);
+HIDDEN Bool isNucleusSem(int* semAdd);
+HIDDEN void releaseAll(int* semAdd, int result);
 HIDDEN void innocentOrNoose(int exceptionType, state_PTR oldState);
 HIDDEN int sys1_createProcess(state_PTR birthState);
-HIDDEN void sys2_terminateProcess();
+HIDDEN void sys2_terminateProcess(int exitCode);
 HIDDEN void sys3_verhogen(int* mutex);
 HIDDEN void sys4_passeren(int* mutex);
 HIDDEN void sys5_specExceptionState(int type, state_PTR old, state_PTR new);
 HIDDEN cpu_t sys6_getCPUTime();
 HIDDEN void sys7_waitForClock();
-HIDDEN void sys8_waitForIODevice(int lineNum, int deviceNum, Bool isReadTerm);
+HIDDEN unsigned int sys8_waitForIODevice(int lineNum, int deviceNum,
+	Bool isReadTerm);
+HIDDEN void sys40_getCPUTimes(cputime_PTR times);
+HIDDEN void sys41_getSysTimes(systime_PTR times);
+HIDDEN void sys42_getClockStats(clockstat_PTR stats);
+HIDDEN void sys43_getIOStats(iostat_PTR stats);
+HIDDEN int sys44_getSemProfile(semprof_PTR top, int n);
+HIDDEN int sys45_batchOps(batchop_PTR ops, int n);
+HIDDEN void sys46_ioRingSetup(ioring_PTR ring);
+HIDDEN int sys47_ioBind(int lineNum, int deviceNum, Bool isReadTerm);
+HIDDEN int sys48_ioWaitAny();
+HIDDEN int sys49_waitAny(int** sems, int n, state_PTR caller);
+HIDDEN int sys50_barrierInit(barrier_PTR b, int parties);
+HIDDEN int sys51_barrierWait(barrier_PTR b);
+HIDDEN int sys52_ecAwait(eventcount_PTR ec, int value);
+HIDDEN int sys53_ecAdvance(eventcount_PTR ec);
+HIDDEN int sys54_seqTicket(sequencer_PTR seq);
+HIDDEN int sys55_send(int dest, Bool isCall);
+HIDDEN int sys56_recv(int from, msg_PTR m);
+HIDDEN int sys58_reply(int to, int word);
+HIDDEN int sys59_getPid();
+HIDDEN void ipcSwitch(pcb_PTR to);
+HIDDEN void deliver(pcb_PTR sender, msg_PTR m);
+HIDDEN int sys60_pipeCreate();
+HIDDEN int sys61_pipeWrite(int id, char* buf, int n);
+HIDDEN int sys62_pipeRead(int id, char* buf, int n);
+HIDDEN int sys63_pipeDestroy(int id);
+HIDDEN void settlePipe(pipe_PTR pp);
+HIDDEN Bool wakePipeReaders(pipe_PTR pp);
+HIDDEN Bool wakePipeWriters(pipe_PTR pp);
+HIDDEN kinfo_PTR sys64_getInfoPage();
+HIDDEN int sys65_terminatePid(int pid);
+HIDDEN int sys66_getProcInfo(int pid, procinfo_PTR info);
+HIDDEN int sys68_join(int pid, int* exitCode);
+HIDDEN int sys69_spawnMany(state_PTR birthState, int n, int stackStride);
+HIDDEN int sys70_pipeClose(int id);
+HIDDEN Bool isNucleusCall(int sysNum);
 
 /********************* External Methods *********************/
 /*
@@ -66,6 +110,7 @@ void copyState(state_PTR orig, state_PTR dest) {
  * the existence of a specified exception state vector (sys5)
  */
 void pgrmTrapHandler() {
+	chargeCurProc(FALSE); /* Time up to the trap was the process's own */
 	innocentOrNoose(PROGTRAP, (state_PTR) PGRMOLDAREA);
 }
 
@@ -79,13 +124,18 @@ void pgrmTrapHandler() {
  * the existence of a specified exception state vector (sys5)
  */
 void tlbHandler() {
+	chargeCurProc(FALSE); /* Time up to the trap was the process's own */
 	innocentOrNoose(TLBTRAP, (state_PTR) TLBOLDAREA);
 }
 
 /*
- * Offer 255 system calls; 1-8 are privileged & the rest are passed up
+ * Offer 255 system calls; 1-8 and the extended nucleus calls
+ * (GETCPUTIMES..LASTNUCSYSCALL) are privileged & the rest are passed up
  * See helper methods for description of each system call.
  *
+ * Time from the trap until the caller resumes is billed to it as
+ * kernel time; time before the trap is its user time.
+ *
  * PARAM: a0 = int for system call number
  */
 void sysCallHandler() {
@@ -93,70 +143,255 @@ void sysCallHandler() {
 	Bool userModeOn;
 	oldSys = (state_PTR) SYSOLDAREA;
 
+	chargeCurProc(FALSE); /* Close the caller's user slice */
+
 	/* Increment PC regardless of whether process lives after this call */
 	oldSys->s_pc = oldSys->s_pc + 4;
 	copyState(oldSys, &(curProc->p_s)); /* Set re-entry context */
 
 	/* Check for reserved instruction error pre-emptively for less code */
 	userModeOn = (oldSys->s_status & USERMODEON) > 0;
-	if(userModeOn && oldSys->s_a0 <= 8 && oldSys->s_a0 > 0) {
+	if(userModeOn && isNucleusCall(oldSys->s_a0)) {
 		/* Set Reserved Instruction in Cause to handle as PROG TRAP */
 		copyState(oldSys, (state_PTR) PGRMOLDAREA);
 		((state_PTR) PGRMOLDAREA)->s_cause =
 			(oldSys->s_cause & NOCAUSE) | RESERVEDINSTERR;
-		pgrmTrapHandler();
+		innocentOrNoose(PROGTRAP, (state_PTR) PGRMOLDAREA);
 	}
 
 	/* Let a0 register decide SysCall type and execute appropriate method */
 	switch(oldSys->s_a0) {
 		case 1:
 			oldSys->s_v0 = sys1_createProcess((state_PTR) oldSys->s_a1);
-			loadState(oldSys);
+			break;
 
 		case 2:
-			sys2_terminateProcess();
+			sys2_terminateProcess(EXITNORMAL);
 
 		case 3:
 			sys3_verhogen((int*) oldSys->s_a1);
-			loadState(oldSys);
+			break;
 
 		case 4:
 			sys4_passeren((int*) oldSys->s_a1);
-			loadState(oldSys); /* If not blocked on P: continue */
+			break; /* If not blocked on P: continue */
 
 		case 5:
 			sys5_specExceptionState(oldSys->s_a1,
 				(state_PTR) oldSys->s_a2,
 				(state_PTR) oldSys->s_a3);
-			loadState(oldSys);
+			break;
 
 		case 6:
 			oldSys->s_v0 = sys6_getCPUTime();
-			loadState(oldSys);
+			break;
 
 		case 7:
 			sys7_waitForClock();
 
 		case 8:
-			sys8_waitForIODevice(oldSys->s_a1, oldSys->s_a2, oldSys->s_a3);
+			oldSys->s_v0 = sys8_waitForIODevice(oldSys->s_a1, oldSys->s_a2,
+				oldSys->s_a3);
+			break; /* Only if the I/O had already completed */
+
+		case GETCPUTIMES:
+			sys40_getCPUTimes((cputime_PTR) oldSys->s_a1);
+			break;
+
+		case GETSYSTIMES:
+			sys41_getSysTimes((systime_PTR) oldSys->s_a1);
+			break;
+
+		case GETCLOCKSTATS:
+			sys42_getClockStats((clockstat_PTR) oldSys->s_a1);
+			break;
+
+		case GETIOSTATS:
+			sys43_getIOStats((iostat_PTR) oldSys->s_a1);
+			break;
+
+		case GETSEMPROFILE:
+			oldSys->s_v0 = sys44_getSemProfile((semprof_PTR) oldSys->s_a1,
+				oldSys->s_a2);
+			break;
+
+		case BATCHOPS:
+			oldSys->s_v0 = sys45_batchOps((batchop_PTR) oldSys->s_a1,
+				oldSys->s_a2);
+			break;
+
+		case IORINGSETUP:
+			sys46_ioRingSetup((ioring_PTR) oldSys->s_a1);
+			break;
+
+		case IOBIND:
+			oldSys->s_v0 = sys47_ioBind(oldSys->s_a1, oldSys->s_a2,
+				oldSys->s_a3);
+			break;
+
+		case IOWAITANY:
+			oldSys->s_v0 = sys48_ioWaitAny(); /* Only if not blocked */
+			break;
+
+		case WAITANY:
+			oldSys->s_v0 = sys49_waitAny((int**) oldSys->s_a1, oldSys->s_a2,
+				oldSys); /* Only if not blocked */
+			break;
+
+		case BARRIERINIT:
+			oldSys->s_v0 = sys50_barrierInit((barrier_PTR) oldSys->s_a1,
+				oldSys->s_a2);
+			break;
+
+		case BARRIERWAIT:
+			/* Only if last to arrive */
+			oldSys->s_v0 = sys51_barrierWait((barrier_PTR) oldSys->s_a1);
+			break;
+
+		case ECAWAIT:
+			/* Only if not blocked */
+			oldSys->s_v0 = sys52_ecAwait((eventcount_PTR) oldSys->s_a1,
+				oldSys->s_a2);
+			break;
+
+		case ECADVANCE:
+			oldSys->s_v0 = sys53_ecAdvance((eventcount_PTR) oldSys->s_a1);
+			break;
+
+		case SEQTICKET:
+			oldSys->s_v0 = sys54_seqTicket((sequencer_PTR) oldSys->s_a1);
+			break;
+
+		case SEND:
+			/* Only if the send failed */
+			oldSys->s_v0 = sys55_send(oldSys->s_a1, FALSE);
+			break;
+
+		case RECV:
+			/* Only if a sender was waiting */
+			oldSys->s_v0 = sys56_recv(oldSys->s_a1, (msg_PTR) oldSys->s_a2);
+			break;
+
+		case CALL:
+			/* Only if the call failed */
+			oldSys->s_v0 = sys55_send(oldSys->s_a1, TRUE);
+			break;
+
+		case REPLY:
+			oldSys->s_v0 = sys58_reply(oldSys->s_a1, oldSys->s_a2);
+			break;
+
+		case GETPID:
+			oldSys->s_v0 = sys59_getPid();
+			break;
+
+		case PIPECREATE:
+			oldSys->s_v0 = sys60_pipeCreate();
+			break;
+
+		case PIPEWRITE:
+			/* Only if not blocked */
+			oldSys->s_v0 = sys61_pipeWrite(oldSys->s_a1, (char*) oldSys->s_a2,
+				oldSys->s_a3);
+			break;
+
+		case PIPEREAD:
+			/* Only if not blocked */
+			oldSys->s_v0 = sys62_pipeRead(oldSys->s_a1, (char*) oldSys->s_a2,
+				oldSys->s_a3);
+			break;
+
+		case PIPEDESTROY:
+			oldSys->s_v0 = sys63_pipeDestroy(oldSys->s_a1);
+			break;
+
+		case GETINFOPAGE:
+			oldSys->s_v0 = (int) sys64_getInfoPage();
+			break;
+
+		case TERMINATEPID:
+			/* Only if the caller survived */
+			oldSys->s_v0 = sys65_terminatePid(oldSys->s_a1);
+			break;
+
+		case GETPROCINFO:
+			oldSys->s_v0 = sys66_getProcInfo(oldSys->s_a1,
+				(procinfo_PTR) oldSys->s_a2);
+			break;
+
+		case EXITPROCESS:
+			/* TERMINATEPROCESS with an exit code for the parent's JOIN */
+			sys2_terminateProcess(oldSys->s_a1);
+
+		case JOIN:
+			/* Only if not blocked */
+			oldSys->s_v0 = sys68_join(oldSys->s_a1, (int*) oldSys->s_a2);
+			break;
+
+		case SPAWNMANY:
+			oldSys->s_v0 = sys69_spawnMany((state_PTR) oldSys->s_a1,
+				oldSys->s_a2, oldSys->s_a3);
+			break;
+
+		case PIPECLOSE:
+			oldSys->s_v0 = sys70_pipeClose(oldSys->s_a1);
+			break;
 
 		default: /* SYSCALL for unhandled method >= 9 */
 			innocentOrNoose(SYSTRAP, oldSys);
 	}
+
+	/* Caller survived without blocking; bill the service and resume it */
+	chargeCurProc(TRUE);
+	loadState(oldSys);
+}
+
+/*
+ * wakeWaitAny - Finishes the WAITANY of p, just removed from the ASL by a
+ *   V on p->p_semAdd: cancels its waits on the other sema4s, reports the
+ *   index that fired in v0 and, for a device sema4, its status in v1.
+ *
+ * Whoever V'd a nucleus sema4 adjusts softBlkCount as for any device
+ * waiter; a plain V releasing a soft blocked WAITANY is accounted here.
+ */
+void wakeWaitAny(pcb_PTR p) {
+	int i, fired = 0;
+
+	/* removeBlocked cleared the node that fired */
+	for(i = 0; i < p->p_waitCount; i++) {
+		if(p->p_waits[i].w_semAdd == NULL)
+			fired = i;
+	}
+
+	cancelWaits(p, TRUE);
+	p->p_s.s_v0 = fired;
+
+	if(isNucleusSem(p->p_semAdd)) {
+		if(p->p_semAdd != psuedoClock)
+			p->p_s.s_v1 = devStatus[p->p_semAdd - semaphores];
+
+	} else if(p->p_waitSoft) {
+		softBlkCount--;
+	}
+
+	p->p_waitCount = 0;
+	p->p_waitSoft = FALSE;
 }
 
 /********************** Helper methods **********************/
 /*
  * avadaKedavra - Mutator method to recursively kill the given pcb_PTR
- * and all of its progeny. Leaves parent and siblings unaffected.
+ * and all of its progeny. Leaves siblings unaffected; the parent is
+ * told the exit code, for its JOIN, and p is taken off its children.
  * pcb can only be executing (curProc), ready (in queue), or waiting (blocked)
  * Used for sys2 abstraction
  */
-HIDDEN void avadaKedavra(pcb_PTR p) {
-	int* semStart, *semEnd;
+HIDDEN void avadaKedavra(pcb_PTR p, int exitCode) {
+	pcb_PTR r;
+	int i;
 	/* Top-down method, kill the children first */
 	while(!emptyChild(p)) {
-		avadaKedavra(removeChild(p));
+		avadaKedavra(removeChild(p), EXITKILLED);
 	}
 
 	/* bottom-up: dealing with each individual PCB
@@ -165,40 +400,161 @@ HIDDEN void avadaKedavra(pcb_PTR p) {
 	if(outProcQ(&deathRowLine, p) != NULL) {
 		/* Know p was on Ready Queue, do nothing else */
 
-	} else if(outBlocked(p) != NULL) {
-		semStart = &(semaphores[0]);
-		semEnd = &(semaphores[MAXSEMS - 1]);
+	} else if(p->p_waitCount > 0) {
+		/* Blocked in WAITANY; same rules as below for each sema4 */
+		cancelWaits(p, FALSE);
+		if(p->p_waitSoft)
+			softBlkCount--;
 
-		if(semStart <= p->p_semAdd && p->p_semAdd <= semEnd) {
+	} else if(p != curProc && outBlocked(p) != NULL) {
+		/* curProc's p_semAdd is stale, it must not be looked up */
+		if(isNucleusSem(p->p_semAdd)) {
 			/* P blocked on device sema4; sema4++ in intHandler */
 			softBlkCount--;
 
+		} else if(p->p_ioRing != NULL &&
+				p->p_semAdd == &(p->p_ioRing->r_tail)) {
+			/* P waited on its completion ring, not a real sema4 */
+			softBlkCount--;
+
 		} else {
 			(*(p->p_semAdd))++; /* P blocked on NON device sema4 */
 		}
 	} /* else it was the curProc which is already handled in sys2 */
 
+	/* Fail the IPC peers still waiting on it */
+	releaseAll(&(p->p_ipcSenders), FAILURE);
+	releaseAll(&(p->p_ipcCallers), FAILURE);
+	while((r = removeBlocked(&(p->p_ipcRecvers))) != NULL) {
+		r->p_ipcFrom = NOPID;
+		r->p_s.s_v0 = FAILURE;
+		putInPool(r);
+	}
+
+	/* Hand its async devices back to WAITIO */
+	if(p->p_ioRing != NULL) {
+		for(i = 0; i < DEVSEMNUM; i++) {
+			if(ringOwner[i] == p)
+				ringOwner[i] = NULL;
+		}
+	}
+
+	/* Tell a surviving parent; progeny were already detached above */
+	if(p->p_prnt != NULL) {
+		reportExit(p->p_prnt, p->p_pid, exitCode);
+		outChild(p);
+	}
+
 	/* Adjust procCount */
 	freePcb(p);
 	procCount--;
 }
 
+/*
+ * reportExit - Deliver a child's exit to parent: straight to its JOIN
+ *   if it is blocked waiting for this child, otherwise kept in its
+ *   p_exits for a later JOIN
+ */
+HIDDEN void reportExit(pcb_PTR parent, int pid, int exitCode) {
+	int i;
+
+	if(headBlocked(&(parent->p_joinSem)) == parent &&
+			(parent->p_joinPid == ANYCHILD || parent->p_joinPid == pid)) {
+		removeBlocked(&(parent->p_joinSem));
+		parent->p_s.s_v0 = pid;
+		if(parent->p_s.s_a2 != 0)
+			*((int*) parent->p_s.s_a2) = exitCode;
+
+		putInPool(parent);
+		return;
+	}
+
+	if(parent->p_exitCount == MAXEXITRECS) {
+		/* Forget the oldest exit */
+		for(i = 1; i < MAXEXITRECS; i++) {
+			parent->p_exits[i - 1] = parent->p_exits[i];
+		}
+		parent->p_exitCount--;
+	}
+
+	parent->p_exits[parent->p_exitCount].e_pid = pid;
+	parent->p_exits[parent->p_exitCount].e_code = exitCode;
+	parent->p_exitCount++;
+}
+
 /*
  * blockCurProc - Track the current process's cpu time and block it
  *   on the given semaphore before scheduling the next job.
  */
 HIDDEN void blockCurProc(int* semAdd) {
-	/* Handle timer stuff */
-	cpu_t stopTOD;
-	STCK(stopTOD);
-	curProc->p_CPUTime += stopTOD - startTOD;
-
 	/* Block on sema4 */
 	insertBlocked(semAdd, curProc);
+	parkCurProc();
+}
+
+/*
+ * parkCurProc - Bill curProc for its SYSCALL and schedule the next job,
+ *   once curProc has been queued on the ASL
+ */
+HIDDEN void parkCurProc() {
+	/* Time since the trap was spent servicing curProc's SYSCALL */
+	chargeCurProc(TRUE);
+	curProc->p_blockTOD = startTOD; /* For the contention profile */
+
 	curProc = NULL;
 	nextVictim();
 }
 
+/*
+ * cancelWaits - Takes p's WAITANY wait nodes off every sema4 they are
+ *   still queued on, undoing the P on each.
+ * PARAM: undoNucleus is FALSE when p is being terminated; as with a
+ *        plain WAITIO, the device sema4 then stays P'd for intHandler
+ */
+HIDDEN void cancelWaits(pcb_PTR p, Bool undoNucleus) {
+	int i;
+	int* semAdd;
+
+	for(i = 0; i < p->p_waitCount; i++) {
+		semAdd = p->p_waits[i].w_semAdd;
+
+		if(outWaitNode(&(p->p_waits[i])) != NULL &&
+				(undoNucleus || !isNucleusSem(semAdd)))
+			(*semAdd)++;
+	}
+}
+
+/*
+ * releaseAll - Readies every process blocked on semAdd at once, with
+ *   result in v0, splicing them onto the ready queue whole
+ */
+HIDDEN void releaseAll(int* semAdd, int result) {
+	pcb_PTR released, p;
+
+	released = removeAllBlocked(semAdd);
+	if(emptyProcQ(released))
+		return;
+
+	p = released;
+	do {
+		p = p->p_next;
+		p->p_s.s_v0 = result;
+
+		if(p->p_waitCount > 0)
+			wakeWaitAny(p);
+	} while(p != released);
+
+	mergeProcQ(&deathRowLine, released);
+}
+
+/*
+ * isNucleusSem - TRUE if semAdd is one of the device sema4s or the
+ *   psuedo-clock, i.e. a sema4 that intHandler V's
+ */
+HIDDEN Bool isNucleusSem(int* semAdd) {
+	return &(semaphores[0]) <= semAdd && semAdd <= &(semaphores[MAXSEMS - 1]);
+}
+
 /*
  * Decides whether to kill process for exception,
  *    or to fulfill specified exception behaviour.
@@ -212,7 +568,7 @@ HIDDEN void innocentOrNoose(int exceptionType, state_PTR oldState) {
 	/* Check exception type and for a corresponding excep state vector */
 	if(curProc->p_exceptionConfig[OLD][exceptionType] == NULL)
 		/* Default case, nexception state not specified */
-		sys2_terminateProcess();
+		sys2_terminateProcess(EXITTRAPPED);
 
 	/*
 	 * Pass up the processor state from old area into the process blk's
@@ -221,6 +577,7 @@ HIDDEN void innocentOrNoose(int exceptionType, state_PTR oldState) {
 	 */
 	copyState(oldState, curProc->p_exceptionConfig[OLD][exceptionType]);
 	copyState(curProc->p_exceptionConfig[NEW][exceptionType], &(curProc->p_s));
+	chargeCurProc(TRUE); /* Passing up is done on the process's behalf */
 	loadState(&(curProc->p_s));
 }
 
@@ -230,7 +587,7 @@ HIDDEN void innocentOrNoose(int exceptionType, state_PTR oldState) {
  * EX: int SYSCALL (CREATEPROCESS, state_PTR statep)
  *    Where CREATEPROCESS has the value of 1.
  * PARAM: a1 = physical address of processor state area
- * RETURN: v0 = 0 (CHILD) on success, -1 (NOCHILD) on failure
+ * RETURN: v0 = the child's PID (> 0) on success, -1 (NOCHILD) on failure
  */
 HIDDEN int sys1_createProcess(state_PTR birthState) {
 	/* Birth new process as child of executing pcb */
@@ -244,7 +601,7 @@ HIDDEN int sys1_createProcess(state_PTR birthState) {
 
 	putInPool(child); /* insert child to the deathRowLine */
 	procCount++;
-	return CHILD;
+	return child->p_pid;
 }
 
 /*
@@ -263,9 +620,8 @@ HIDDEN int sys1_createProcess(state_PTR birthState) {
  * EX: void SYSCALL (TERMINATEPROCESS)
  *   Where TERMINATEPROCESS has the value of 2.
  */
-HIDDEN void sys2_terminateProcess() {
-	outChild(curProc);
-	avadaKedavra(curProc);
+HIDDEN void sys2_terminateProcess(int exitCode) {
+	avadaKedavra(curProc, exitCode);
 	curProc = NULL;
 	nextVictim();
 }
@@ -278,12 +634,21 @@ HIDDEN void sys2_terminateProcess() {
  * PARAM: a1 = semaphore address
  */
 HIDDEN void sys3_verhogen(int* mutex) {
+	pcb_PTR p;
+	cpu_t wakeTOD;
+
 	(*mutex)++;
+	profV(mutex);
 
 	if((*mutex) <= 0) {
 		/* Give turn to next waiting process from semaphore */
 		if(headBlocked(mutex)) {
-			putInPool(removeBlocked(mutex));
+			putInPool(p = removeBlocked(mutex));
+			STCK(wakeTOD);
+			profWake(p, wakeTOD);
+
+			if(p->p_waitCount > 0)
+				wakeWaitAny(p);
 		}
 	}
 }
@@ -297,6 +662,7 @@ HIDDEN void sys3_verhogen(int* mutex) {
  */
 HIDDEN void sys4_passeren(int* mutex) {
 	(*mutex)--;
+	profP(mutex);
 
 	if((*mutex) < 0) {
 		/* Put process in line to use semaphore and move on */
@@ -322,7 +688,7 @@ HIDDEN void sys4_passeren(int* mutex) {
 HIDDEN void sys5_specExceptionState(int type, state_PTR old, state_PTR new) {
 	if(curProc->p_exceptionConfig[OLD][type] != NULL)
 		/* Error, exception state already specified */
-		sys2_terminateProcess();
+		sys2_terminateProcess(EXITTRAPPED);
 
 	/* Specify old and new state vectors */
 	curProc->p_exceptionConfig[OLD][type] = old;
@@ -355,6 +721,7 @@ HIDDEN cpu_t sys6_getCPUTime() {
 HIDDEN void sys7_waitForClock() {
 	/* Select and P the psuedo-clock timer */
 	(*psuedoClock)--;
+	profP(psuedoClock);
 
 	if((*psuedoClock) < 0) {
 		softBlkCount++;
@@ -367,25 +734,1013 @@ HIDDEN void sys7_waitForClock() {
  * on the semaphore associated with the I/O device
  * indicated by the values in a1, a2[, a3]
  *
+ * If the interrupt beat the WAITIO, the sema4 was already V'd and the
+ * caller gets the status intHandler saved, without blocking.
+ *
+ * A device IOBIND has bound to a ring never has its sema4 V'd, so a
+ * WAITIO on it fails rather than block for good.
+ *
  * EX: unsigned int SYSCALL (WAITIO, int intlNo, int dnum, Bool isReadTerminal)
  *    Where the mnemonic constant WAITIO has the value of 8.
  * PARAM: a1 = Interrupt line number ([0..7])
  *        a2 = device number ([0..7])
  *        a3 = wait for terminal read operation -> SysCall TRUE / FALSE
+ * RETURN: v0 = device status, FAILURE if the device is bound to a ring
  */
-HIDDEN void sys8_waitForIODevice(int lineNum, int deviceNum, Bool isReadTerm) {
+HIDDEN unsigned int sys8_waitForIODevice(int lineNum, int deviceNum,
+		Bool isReadTerm) {
 	/* Choose appropriate semaphore */
 	int* semAdd = findSem(lineNum, deviceNum, isReadTerm);
+	iostat_PTR stats = &(ioStats[semAdd - semaphores]);
+
+	if(ringOwner[semAdd - semaphores] != NULL)
+		return FAILURE;
+
 	(*semAdd)--;
+	profP(semAdd);
 
 	/* Remove curProc and place on semaphore if successful */
 	/* Replicate sys4 code for special handling */
 	if((*semAdd) < 0) {
+		/* Stamp the block so intHandler can time the service */
+		stats->io_maxWaiters = MAX(stats->io_maxWaiters, -(*semAdd));
+		curProc->p_ioSlot = semAdd - semaphores;
+		STCK(curProc->p_ioTOD);
+
 		softBlkCount++;
 		blockCurProc(semAdd);
+	}
+
+	/* The I/O completed before we got here */
+	return devStatus[semAdd - semaphores];
+}
+
+/*
+ * Reports the requesting process's CPU time split into the time spent
+ * running its own code and the time the nucleus spent on its SYSCALLs.
+ *
+ * EX: void SYSCALL (GETCPUTIMES, cputime_t *times)
+ *    Where the mnemonic constant GETCPUTIMES has the value of 40.
+ * PARAM: a1 = address of a cputime_t to fill in (microseconds)
+ */
+HIDDEN void sys40_getCPUTimes(cputime_PTR times) {
+	chargeCurProc(TRUE); /* Bring the meters up to date */
+
+	times->c_total = curProc->p_CPUTime;
+	times->c_kernel = curProc->p_kernTime;
+	times->c_user = curProc->p_CPUTime - curProc->p_kernTime;
+}
+
+/*
+ * Takes a system-wide utilization snapshot: wall time since boot, time
+ * the processor sat idle in WAIT, and time spent handling interrupts.
+ * Whatever remains was billed to processes or spent scheduling.
+ *
+ * EX: void SYSCALL (GETSYSTIMES, systime_t *times)
+ *    Where the mnemonic constant GETSYSTIMES has the value of 41.
+ * PARAM: a1 = address of a systime_t to fill in (microseconds)
+ */
+HIDDEN void sys41_getSysTimes(systime_PTR times) {
+	cpu_t now;
+	STCK(now);
+
+	times->st_total = now - bootTOD;
+	times->st_idle = idleTime;
+	times->st_inter = interTime;
+}
+
+/*
+ * Copies out the pseudo-clock's tick timing: how many ticks fired, how
+ * many deadlines were missed and the min/avg/max lateness of a tick.
+ * Lets periodic WAITCLOCK loops verify their timing.
+ *
+ * EX: void SYSCALL (GETCLOCKSTATS, clockstat_t *stats)
+ *    Where the mnemonic constant GETCLOCKSTATS has the value of 42.
+ * PARAM: a1 = address of a clockstat_t to fill in (microseconds)
+ */
+HIDDEN void sys42_getClockStats(clockstat_PTR stats) {
+	stats->ck_ticks = clockStats.ck_ticks;
+	stats->ck_missed = clockStats.ck_missed;
+	stats->ck_minJitter = clockStats.ck_minJitter;
+	stats->ck_maxJitter = clockStats.ck_maxJitter;
+	stats->ck_sumJitter = clockStats.ck_sumJitter;
+	stats->ck_avgJitter = clockStats.ck_avgJitter;
+}
+
+/*
+ * Copies out the WAITIO latency statistics of every device sema4:
+ * service time and wakeup delay histograms plus the deepest queue.
+ *
+ * EX: void SYSCALL (GETIOSTATS, iostat_t stats[DEVSEMNUM])
+ *    Where the mnemonic constant GETIOSTATS has the value of 43.
+ * PARAM: a1 = address of DEVSEMNUM iostat_t's, indexed by DEVSEMINDEX
+ */
+HIDDEN void sys43_getIOStats(iostat_PTR stats) {
+	int i, j;
+
+	for(i = 0; i < DEVSEMNUM; i++) {
+		stats[i].io_count = ioStats[i].io_count;
+		stats[i].io_maxWaiters = ioStats[i].io_maxWaiters;
+		stats[i].io_sumService = ioStats[i].io_sumService;
+		stats[i].io_maxService = ioStats[i].io_maxService;
+		stats[i].io_sumWakeup = ioStats[i].io_sumWakeup;
+		stats[i].io_maxWakeup = ioStats[i].io_maxWakeup;
+
+		for(j = 0; j < IOHISTBUCKETS; j++) {
+			stats[i].io_serviceHist[j] = ioStats[i].io_serviceHist[j];
+			stats[i].io_wakeupHist[j] = ioStats[i].io_wakeupHist[j];
+		}
+	}
+}
+
+/*
+ * Reports the n semaphores that kept processes blocked the longest,
+ * with their P, contended P and V counts, total and max time blocked
+ * and deepest queue. Covers device and user semaphores alike.
+ *
+ * EX: int SYSCALL (GETSEMPROFILE, semprof_t top[n], int n)
+ *    Where the mnemonic constant GETSEMPROFILE has the value of 44.
+ * PARAM: a1 = address of n semprof_t's to fill, most contended first
+ *        a2 = n
+ * RETURN: v0 = number of entries filled in
+ */
+HIDDEN int sys44_getSemProfile(semprof_PTR top, int n) {
+	return topSemProfiles(top, n);
+}
+
+/*
+ * Runs an array of semaphore and clock operations in order within a
+ * single kernel entry, so bursts of V's pay for one trap instead of many.
+ * Execution stops at the first P that would block (it is not performed,
+ * the caller may issue a plain PASSEREN for it) or at an unknown op.
+ *
+ * Per-op b_result: VERHOGEN 1 if it released a process else 0,
+ * PASSEREN 0, BROADCASTV number of processes released, GETCPUTIME the
+ * processor time; BATCHWOULDBLOCK or BATCHBADOP for the stopping op.
+ *
+ * EX: int SYSCALL (BATCHOPS, batchop_t ops[n], int n)
+ *    Where the mnemonic constant BATCHOPS has the value of 45.
+ * PARAM: a1 = address of n batchop_t's
+ *        a2 = n
+ * RETURN: v0 = number of operations completed
+ */
+HIDDEN int sys45_batchOps(batchop_PTR ops, int n) {
+	int i, *mutex;
+
+	for(i = 0; i < n; i++) {
+		mutex = (int*) ops[i].b_arg;
+
+		switch(ops[i].b_op) {
+			case VERHOGEN:
+				ops[i].b_result = ((*mutex) < 0) ? 1 : 0;
+				sys3_verhogen(mutex);
+				break;
+
+			case PASSEREN:
+				if((*mutex) <= 0) {
+					ops[i].b_result = BATCHWOULDBLOCK;
+					return i;
+				}
+
+				sys4_passeren(mutex); /* Known not to block */
+				ops[i].b_result = 0;
+				break;
+
+			case BROADCASTV:
+				ops[i].b_result = 0;
+				while((*mutex) < 0) {
+					sys3_verhogen(mutex);
+					ops[i].b_result++;
+				}
+				break;
+
+			case GETCPUTIME:
+				ops[i].b_result = sys6_getCPUTime();
+				break;
+
+			default:
+				ops[i].b_result = BATCHBADOP;
+				return i;
+		}
+	}
+
+	return n;
+}
 
+/*
+ * Registers a completion ring in the caller's memory for asynchronous
+ * I/O, replacing any earlier ring, and empties it. Devices bound with
+ * IOBIND report their completions into this ring.
+ *
+ * EX: void SYSCALL (IORINGSETUP, ioring_t *ring)
+ *    Where the mnemonic constant IORINGSETUP has the value of 46.
+ * PARAM: a1 = address of the ring
+ */
+HIDDEN void sys46_ioRingSetup(ioring_PTR ring) {
+	ring->r_head = 0;
+	ring->r_tail = 0;
+	ring->r_dropped = 0;
+	curProc->p_ioRing = ring;
+	curProc->p_ioTail = 0;
+}
+
+/*
+ * Binds a device to the caller's completion ring. From then on the
+ * caller starts I/O by writing the device register as usual, but never
+ * WAITIOs on it: intHandler appends {device, status, time} to the ring
+ * instead of V'ing the device sema4. One process can thus keep many
+ * devices busy at once. The binding lasts until the caller terminates.
+ *
+ * EX: int SYSCALL (IOBIND, int intlNo, int dnum, Bool isReadTerminal)
+ *    Where the mnemonic constant IOBIND has the value of 47.
+ * PARAM: a1 = Interrupt line number ([3..7])
+ *        a2 = device number ([0..7])
+ *        a3 = TRUE to bind a terminal's receiver, FALSE its transmitter
+ * RETURN: v0 = SUCCESS, or FAILURE if the caller has no ring, the
+ *         device does not exist, is bound elsewhere or has WAITIOs
+ */
+HIDDEN int sys47_ioBind(int lineNum, int deviceNum, Bool isReadTerm) {
+	int slot;
+
+	if(curProc->p_ioRing == NULL || lineNum < DISKINT || lineNum > TERMINT ||
+			deviceNum < 0 || deviceNum >= DEVPERINT)
+		return FAILURE;
+
+	slot = DEVSEMINDEX(lineNum, deviceNum, lineNum == TERMINT && isReadTerm);
+	if((ringOwner[slot] != NULL && ringOwner[slot] != curProc) ||
+			semaphores[slot] < 0)
+		return FAILURE;
+
+	ringOwner[slot] = curProc;
+	return SUCCESS;
+}
+
+/*
+ * Waits for any bound device to complete. Returns straight away if the
+ * caller's ring already holds entries, otherwise blocks (softly, like
+ * WAITIO) until intHandler posts the next completion.
+ *
+ * EX: int SYSCALL (IOWAITANY)
+ *    Where the mnemonic constant IOWAITANY has the value of 48.
+ * RETURN: v0 = number of entries ready in the ring, FAILURE if none is
+ *         registered
+ */
+HIDDEN int sys48_ioWaitAny() {
+	ioring_PTR ring = curProc->p_ioRing;
+
+	if(ring == NULL)
+		return FAILURE;
+
+	if(ringCount(curProc) > 0)
+		return ringCount(curProc);
+
+	/* The ring's r_tail address is a private key on the ASL */
+	softBlkCount++;
+	blockCurProc(&(ring->r_tail));
+	return 0; /* Not reached, v0 is set by intHandler */
+}
+
+/*
+ * ringCount - Number of completions waiting in p's ring to be consumed;
+ *   none if the process left r_head out of range
+ */
+int ringCount(pcb_PTR p) {
+	int head = p->p_ioRing->r_head;
+
+	if(head < 0 || head >= IORINGSIZE)
+		return 0;
+
+	return (p->p_ioTail - head + IORINGSIZE) % IORINGSIZE;
+}
+
+/*
+ * Waits until any one of several sema4s can be P'd, e.g. a terminal's
+ * read sema4 and a work queue, without a helper process per source.
+ * If one is already positive it is P'd and the call returns at once.
+ * Otherwise the caller is P'd and queued on all of them in the ASL; the
+ * first V releases it and its waits on the others are cancelled.
+ *
+ * Nucleus sema4s are named by index instead of address: DEVSEMINDEX
+ * for a device (which must be started, as for WAITIO, and not bound to
+ * a ring by IOBIND) or MAXSEMS - 1 for the psuedo-clock.
+ *
+ * EX: int SYSCALL (WAITANY, int *sems[n], int n)
+ *    Where the mnemonic constant WAITANY has the value of 49.
+ * PARAM: a1 = address of n sema4 addresses (or nucleus sema4 indices)
+ *        a2 = n, at most MAXWAITANY
+ * RETURN: v0 = index into sems of the sema4 that was P'd, FAILURE if n
+ *         is out of range, a device is bound to a ring or the ASL ran
+ *         out of descriptors
+ *         v1 = device status, when v0 names a device sema4
+ */
+HIDDEN int sys49_waitAny(int** sems, int n, state_PTR caller) {
+	int i;
+	int* semAdd;
+	int* semAdds[MAXWAITANY];
+	Bool isSoft = FALSE;
+
+	if(n < 1 || n > MAXWAITANY)
+		return FAILURE;
+
+	/* Name nucleus sema4s by index; the caller's array is left as is */
+	for(i = 0; i < n; i++) {
+		if((memaddr) sems[i] < MAXSEMS)
+			semAdds[i] = &(semaphores[(memaddr) sems[i]]);
+		else
+			semAdds[i] = sems[i];
+
+		if(isNucleusSem(semAdds[i]) && semAdds[i] != psuedoClock &&
+				ringOwner[semAdds[i] - semaphores] != NULL)
+			return FAILURE;
+	}
+
+	/* Take one that is already available */
+	for(i = 0; i < n; i++) {
+		semAdd = semAdds[i];
+		if((*semAdd) > 0) {
+			(*semAdd)--;
+			profP(semAdd);
+
+			if(isNucleusSem(semAdd) && semAdd != psuedoClock)
+				caller->s_v1 = devStatus[semAdd - semaphores];
+			return i;
+		}
+	}
+
+	/* P all of them and queue on each */
+	for(i = 0; i < n; i++) {
+		semAdd = semAdds[i];
+		if(insertWaitNode(semAdd, &(curProc->p_waits[i]))) {
+			/* Out of sema4 descriptors; back out what was queued */
+			curProc->p_waitCount = i;
+			cancelWaits(curProc, TRUE);
+			curProc->p_waitCount = 0;
+			return FAILURE;
+		}
+
+		(*semAdd)--;
+		profP(semAdd);
+		isSoft = isSoft || isNucleusSem(semAdd);
+	}
+
+	curProc->p_waitCount = n;
+	curProc->p_waitSoft = isSoft;
+	if(isSoft)
+		softBlkCount++;
+
+	parkCurProc();
+	return 0; /* Not reached, v0 is set by wakeWaitAny */
+}
+
+/*
+ * Sets up a barrier in the caller's memory for parties processes.
+ * Fails if processes are still blocked at it.
+ *
+ * EX: int SYSCALL (BARRIERINIT, barrier_t *b, int parties)
+ *    Where the mnemonic constant BARRIERINIT has the value of 50.
+ * PARAM: a1 = address of the barrier
+ *        a2 = number of processes per round, at least 1
+ * RETURN: v0 = SUCCESS or FAILURE
+ */
+HIDDEN int sys50_barrierInit(barrier_PTR b, int parties) {
+	if(parties < 1 || headBlocked(&(b->b_remaining)) != NULL)
+		return FAILURE;
+
+	b->b_parties = parties;
+	b->b_remaining = parties;
+	b->b_round = 0;
+	return SUCCESS;
+}
+
+/*
+ * Arrives at barrier b. Every arrival but the last of a round blocks;
+ * the last one takes all of them off the ASL in one go, splices them
+ * onto the ready queue whole and starts the next round.
+ *
+ * A process terminated while waiting gives its arrival back, as a
+ * terminated P does.
+ *
+ * EX: int SYSCALL (BARRIERWAIT, barrier_t *b)
+ *    Where the mnemonic constant BARRIERWAIT has the value of 51.
+ * PARAM: a1 = address of the barrier
+ * RETURN: v0 = BARRIERLAST for the arrival that released the round,
+ *         BARRIERWAITER for the others, FAILURE if the ASL was full
+ */
+HIDDEN int sys51_barrierWait(barrier_PTR b) {
+	b->b_remaining--;
+
+	if(b->b_remaining > 0) {
+		if(insertBlocked(&(b->b_remaining), curProc)) {
+			b->b_remaining++;
+			return FAILURE;
+		}
+
+		parkCurProc();
+	}
+
+	/* Last to arrive; release the round */
+	b->b_round++;
+	b->b_remaining = b->b_parties;
+	releaseAll(&(b->b_remaining), BARRIERWAITER);
+
+	return BARRIERLAST;
+}
+
+/*
+ * Blocks until eventcount ec reaches value. Waiters are kept sorted on
+ * the value they await, so an advance only wakes those it satisfies.
+ *
+ * EX: int SYSCALL (ECAWAIT, eventcount_t *ec, int value)
+ *    Where the mnemonic constant ECAWAIT has the value of 52.
+ * PARAM: a1 = address of the eventcount
+ *        a2 = value to wait for
+ * RETURN: v0 = the eventcount's value, FAILURE if the ASL was full
+ */
+HIDDEN int sys52_ecAwait(eventcount_PTR ec, int value) {
+	if(ec->ec_value >= value)
+		return ec->ec_value;
+
+	if(insertBlockedSorted(&(ec->ec_waiters), curProc, value))
+		return FAILURE;
+
+	ec->ec_waiters--;
+	parkCurProc();
+	return FAILURE; /* Not reached, v0 is set by sys53 */
+}
+
+/*
+ * Advances eventcount ec by one and readies the waiters whose value
+ * has now been reached, leaving the rest blocked.
+ *
+ * EX: int SYSCALL (ECADVANCE, eventcount_t *ec)
+ *    Where the mnemonic constant ECADVANCE has the value of 53.
+ * PARAM: a1 = address of the eventcount
+ * RETURN: v0 = the eventcount's new value
+ */
+HIDDEN int sys53_ecAdvance(eventcount_PTR ec) {
+	pcb_PTR p;
+
+	ec->ec_value++;
+
+	while((p = headBlocked(&(ec->ec_waiters))) != NULL &&
+			(p->p_waitCount > 0 || p->p_waits[0].w_key <= ec->ec_value)) {
+		removeBlocked(&(ec->ec_waiters));
+		ec->ec_waiters++;
+		p->p_s.s_v0 = ec->ec_value;
+
+		if(p->p_waitCount > 0)
+			wakeWaitAny(p);
+		putInPool(p);
+	}
+
+	return ec->ec_value;
+}
+
+/*
+ * Hands out the next ticket of sequencer seq; with an eventcount this
+ * orders processes without a mutex, e.g. t = SEQTICKET; ECAWAIT(t).
+ *
+ * EX: int SYSCALL (SEQTICKET, sequencer_t *seq)
+ *    Where the mnemonic constant SEQTICKET has the value of 54.
+ * PARAM: a1 = address of the sequencer
+ * RETURN: v0 = the ticket
+ */
+HIDDEN int sys54_seqTicket(sequencer_PTR seq) {
+	return seq->sq_next++;
+}
+
+/*
+ * Synchronous message passing: SEND and CALL carry the two words in
+ * a2 & a3 to a process blocked in RECV. If the receiver is already
+ * waiting for us, the message goes straight into its buffer and we
+ * switch directly to it, without passing through death row; otherwise
+ * we block until it RECVs. A SENDer is then done; a CALLer stays
+ * blocked until the receiver REPLYs.
+ *
+ * Processes are named by PID.
+ *
+ * EX: int SYSCALL (SEND, int dest, int w0, int w1)
+ *     int SYSCALL (CALL, int dest, int w0, int w1)
+ *    Where the mnemonic constants SEND & CALL have the values 55 & 57.
+ * PARAM: a1 = PID of the receiver
+ *        a2, a3 = the message
+ * RETURN: v0 = SEND: SUCCESS; CALL: the word REPLYed
+ *         FAILURE if dest is the caller or no live process, the ASL
+ *         was full or the receiver terminated first
+ */
+HIDDEN int sys55_send(int dest, Bool isCall) {
+	pcb_PTR r = findPid(dest);
+
+	if(r == NULL || r == curProc)
+		return FAILURE;
+
+	if(r->p_ipcFrom == ANYSENDER || r->p_ipcFrom == curProc->p_pid) {
+		/* Receiver is waiting for us */
+		if(isCall) {
+			if(insertBlocked(&(r->p_ipcCallers), curProc))
+				return FAILURE;
+		} else {
+			curProc->p_s.s_v0 = SUCCESS;
+			putInPool(curProc);
+		}
+
+		outBlocked(r); /* off its p_ipcRecv or our p_ipcRecvers */
+		r->p_ipcFrom = NOPID;
+		r->p_s.s_v0 = curProc->p_pid;
+		deliver(curProc, (msg_PTR) r->p_s.s_a2);
+		ipcSwitch(r);
+	}
+
+	/* Wait for the receiver; our a0 tells it SEND from CALL */
+	if(insertBlocked(&(r->p_ipcSenders), curProc))
+		return FAILURE;
+
+	parkCurProc();
+	return FAILURE; /* Not reached */
+}
+
+/*
+ * Receives a message into m, from sender from or from whoever comes
+ * first. Blocks until there is one; a sender that is already waiting
+ * is readied (SEND) or moved on to wait for our REPLY (CALL).
+ *
+ * A receiver waiting on one sender waits on that sender's p_ipcRecvers,
+ * so if the sender dies first it is readied with FAILURE.
+ *
+ * EX: int SYSCALL (RECV, int from, msg_t *m)
+ *    Where the mnemonic constant RECV has the value of 56.
+ * PARAM: a1 = PID of the sender, or ANYSENDER
+ *        a2 = address to store the message at
+ * RETURN: v0 = PID of the sender, FAILURE if from is the caller or no
+ *         live process, dies before SENDing or the ASL was full
+ */
+HIDDEN int sys56_recv(int from, msg_PTR m) {
+	pcb_PTR s;
+	int* waitOn = &(curProc->p_ipcRecv);
+
+	if(from == ANYSENDER) {
+		s = removeBlocked(&(curProc->p_ipcSenders));
+	} else {
+		s = findPid(from);
+		if(s == NULL || s == curProc)
+			return FAILURE;
+
+		waitOn = &(s->p_ipcRecvers);
+		if(s->p_semAdd != &(curProc->p_ipcSenders) || outBlocked(s) == NULL)
+			s = NULL;
+	}
+
+	if(s == NULL) {
+		/* Nobody waiting; block until they SEND or CALL */
+		if(insertBlocked(waitOn, curProc))
+			return FAILURE;
+
+		curProc->p_ipcFrom = from;
+		parkCurProc();
+	}
+
+	if(s->p_s.s_a0 == CALL) {
+		if(insertBlocked(&(curProc->p_ipcCallers), s)) {
+			s->p_s.s_v0 = FAILURE;
+			putInPool(s);
+			return FAILURE;
+		}
 	} else {
-		/* Unhandled niche case that doesn't appear in testing */
-		gameOver(EXCEP);
+		s->p_s.s_v0 = SUCCESS;
+		putInPool(s);
 	}
+
+	deliver(s, m);
+	return s->p_pid;
+}
+
+/*
+ * Answers a process blocked in CALL to us, readying it with word.
+ *
+ * EX: int SYSCALL (REPLY, int to, int word)
+ *    Where the mnemonic constant REPLY has the value of 58.
+ * PARAM: a1 = PID of the caller
+ *        a2 = the reply, returned by its CALL
+ * RETURN: v0 = SUCCESS, FAILURE if it is not waiting for our reply
+ */
+HIDDEN int sys58_reply(int to, int word) {
+	pcb_PTR c = findPid(to);
+
+	if(c == NULL || c->p_semAdd != &(curProc->p_ipcCallers) ||
+			outBlocked(c) == NULL)
+		return FAILURE;
+
+	c->p_s.s_v0 = word;
+	putInPool(c);
+	return SUCCESS;
+}
+
+/*
+ * EX: int SYSCALL (GETPID)
+ *    Where the mnemonic constant GETPID has the value of 59.
+ * RETURN: v0 = the caller's PID
+ */
+HIDDEN int sys59_getPid() {
+	return curProc->p_pid;
+}
+
+/*
+ * ipcSwitch - Bill curProc, already queued by the IPC call, and run
+ *   the receiver to in its place
+ */
+HIDDEN void ipcSwitch(pcb_PTR to) {
+	chargeCurProc(TRUE);
+	curProc->p_blockTOD = startTOD;
+	handOff(to);
+}
+
+/*
+ * deliver - Copies the message sender passed in a2 & a3 to m
+ */
+HIDDEN void deliver(pcb_PTR sender, msg_PTR m) {
+	m->m_w0 = sender->p_s.s_a2;
+	m->m_w1 = sender->p_s.s_a3;
+}
+
+/*
+ * Creates a pipe, a PIPESIZE byte ring in kernel memory.
+ *
+ * EX: int SYSCALL (PIPECREATE)
+ *    Where the mnemonic constant PIPECREATE has the value of 60.
+ * RETURN: v0 = id of the pipe, FAILURE if all MAXPIPES are in use
+ */
+HIDDEN int sys60_pipeCreate() {
+	pipe_PTR pp = allocPipe();
+
+	return (pp == NULL) ? FAILURE : pipeId(pp);
+}
+
+/*
+ * Writes up to n bytes from buf into a pipe. Takes what fits and
+ * returns at once; blocks only if the pipe is full (or other writers
+ * are already waiting), until a read frees room for all n bytes or
+ * PIPEWATERMARK of them.
+ *
+ * EX: int SYSCALL (PIPEWRITE, int id, char *buf, int n)
+ *    Where the mnemonic constant PIPEWRITE has the value of 61.
+ * PARAM: a1 = id of the pipe
+ *        a2 = address of the bytes
+ *        a3 = n, at least 1
+ * RETURN: v0 = number of bytes written, FAILURE for a bad id or n or
+ *         if the pipe is closed or destroyed
+ */
+HIDDEN int sys61_pipeWrite(int id, char* buf, int n) {
+	int written;
+	pipe_PTR pp = findPipe(id);
+
+	if(pp == NULL || n < 1 || pp->pp_closed)
+		return FAILURE;
+
+	if(pp->pp_count < PIPESIZE && pp->pp_writeSem == 0) {
+		written = pipeIn(pp, buf, n);
+		settlePipe(pp);
+		return written;
+	}
+
+	/* Full; the reader that makes room copies our bytes in */
+	if(insertBlocked(&(pp->pp_writeSem), curProc))
+		return FAILURE;
+
+	pp->pp_writeSem--;
+	parkCurProc();
+	return FAILURE; /* Not reached, v0 is set by wakePipeWriters */
+}
+
+/*
+ * Reads up to n bytes from a pipe into buf. Takes what is there and
+ * returns at once; blocks only if the pipe is empty (or other readers
+ * are already waiting), until writes bring all n bytes or
+ * PIPEWATERMARK of them, so a stream of small writes wakes the reader
+ * once per batch rather than once per write.
+ *
+ * Once the writer PIPECLOSEs the pipe, a blocked reader is woken by any
+ * bytes left, however few, and reads of the emptied pipe return 0, the
+ * end of the stream.
+ *
+ * EX: int SYSCALL (PIPEREAD, int id, char *buf, int n)
+ *    Where the mnemonic constant PIPEREAD has the value of 62.
+ * PARAM: a1 = id of the pipe
+ *        a2 = address to store the bytes at
+ *        a3 = n, at least 1
+ * RETURN: v0 = number of bytes read, 0 if the pipe is closed and
+ *         empty, FAILURE for a bad id or n or if the pipe is destroyed
+ *         meanwhile
+ */
+HIDDEN int sys62_pipeRead(int id, char* buf, int n) {
+	int got;
+	pipe_PTR pp = findPipe(id);
+
+	if(pp == NULL || n < 1)
+		return FAILURE;
+
+	if(pp->pp_count > 0 && pp->pp_readSem == 0) {
+		got = pipeOut(pp, buf, n);
+		settlePipe(pp);
+		return got;
+	}
+
+	if(pp->pp_closed)
+		return 0;
+
+	/* Empty; the writer that crosses the mark copies the bytes out */
+	if(insertBlocked(&(pp->pp_readSem), curProc))
+		return FAILURE;
+
+	pp->pp_readSem--;
+	parkCurProc();
+	return FAILURE; /* Not reached, v0 is set by wakePipeReaders */
+}
+
+/*
+ * Destroys a pipe; processes blocked on it get FAILURE.
+ *
+ * EX: int SYSCALL (PIPEDESTROY, int id)
+ *    Where the mnemonic constant PIPEDESTROY has the value of 63.
+ * PARAM: a1 = id of the pipe
+ * RETURN: v0 = SUCCESS, FAILURE for a bad id
+ */
+HIDDEN int sys63_pipeDestroy(int id) {
+	pipe_PTR pp = findPipe(id);
+
+	if(pp == NULL)
+		return FAILURE;
+
+	releaseAll(&(pp->pp_readSem), FAILURE);
+	releaseAll(&(pp->pp_writeSem), FAILURE);
+	freePipe(pp);
+	return SUCCESS;
+}
+
+/*
+ * settlePipe - Wake blocked readers and writers of pp until neither
+ *   can make progress, after its contents changed
+ */
+HIDDEN void settlePipe(pipe_PTR pp) {
+	Bool moved;
+
+	do {
+		moved = wakePipeReaders(pp);
+		moved = wakePipeWriters(pp) || moved;
+	} while(moved);
+}
+
+/*
+ * wakePipeReaders - Complete the PIPEREADs blocked on pp, in order,
+ *   while the ring holds what the next one asked for, has crossed
+ *   PIPEWATERMARK or, once pp is closed, holds anything at all. The
+ *   reader's buf & n are still in its a2 & a3.
+ * RETURN: TRUE if any reader was woken
+ */
+HIDDEN Bool wakePipeReaders(pipe_PTR pp) {
+	pcb_PTR p;
+	Bool woke = FALSE;
+
+	while((p = headBlocked(&(pp->pp_readSem))) != NULL && pp->pp_count > 0 &&
+			(pp->pp_count >= p->p_s.s_a3 || pp->pp_count >= PIPEWATERMARK ||
+			pp->pp_closed)) {
+		removeBlocked(&(pp->pp_readSem));
+		pp->pp_readSem++;
+		p->p_s.s_v0 = pipeOut(pp, (char*) p->p_s.s_a2, p->p_s.s_a3);
+		putInPool(p);
+		woke = TRUE;
+	}
+
+	return woke;
+}
+
+/*
+ * wakePipeWriters - Complete the PIPEWRITEs blocked on pp, in order,
+ *   while the ring has room for all the next one offers or for
+ *   PIPEWATERMARK bytes. The writer's buf & n are still in its a2 & a3.
+ * RETURN: TRUE if any writer was woken
+ */
+HIDDEN Bool wakePipeWriters(pipe_PTR pp) {
+	pcb_PTR p;
+	int room;
+	Bool woke = FALSE;
+
+	while((p = headBlocked(&(pp->pp_writeSem))) != NULL &&
+			(room = PIPESIZE - pp->pp_count) > 0 &&
+			(room >= p->p_s.s_a3 || room >= PIPEWATERMARK)) {
+		removeBlocked(&(pp->pp_writeSem));
+		pp->pp_writeSem++;
+		p->p_s.s_v0 = pipeIn(pp, (char*) p->p_s.s_a2, p->p_s.s_a3);
+		putInPool(p);
+		woke = TRUE;
+	}
+
+	return woke;
+}
+
+/*
+ * Locates the kernel info page, from which infopage.c's routines read
+ * the time and the caller's CPU time without trapping.
+ *
+ * EX: kinfo_t *SYSCALL (GETINFOPAGE)
+ *    Where the mnemonic constant GETINFOPAGE has the value of 64.
+ * RETURN: v0 = address of the info page; it must not be written
+ */
+HIDDEN kinfo_PTR sys64_getInfoPage() {
+	return &kernInfo;
+}
+
+/*
+ * Kills the process with the given PID and all its descendents, like
+ * TERMINATEPROCESS does for the caller. The target must be the caller
+ * or one of its descendents.
+ *
+ * EX: int SYSCALL (TERMINATEPID, int pid)
+ *    Where the mnemonic constant TERMINATEPID has the value of 65.
+ * PARAM: a1 = PID of the subtree's root
+ * RETURN: v0 = SUCCESS, FAILURE if pid is stale or not a descendent
+ */
+HIDDEN int sys65_terminatePid(int pid) {
+	pcb_PTR p = findPid(pid);
+	pcb_PTR ancestor;
+
+	if(p == NULL)
+		return FAILURE;
+
+	if(p == curProc)
+		sys2_terminateProcess(EXITKILLED);
+
+	ancestor = p->p_prnt;
+	while(ancestor != NULL && ancestor != curProc) {
+		ancestor = ancestor->p_prnt;
+	}
+
+	if(ancestor == NULL)
+		return FAILURE;
+
+	avadaKedavra(p, EXITKILLED);
+	return SUCCESS;
+}
+
+/*
+ * Reports the state and processor time of any live process.
+ *
+ * EX: int SYSCALL (GETPROCINFO, int pid, procinfo_t *info)
+ *    Where the mnemonic constant GETPROCINFO has the value of 66.
+ * PARAM: a1 = PID of the process
+ *        a2 = address of the procinfo_t to fill in
+ * RETURN: v0 = SUCCESS, FAILURE if pid is stale
+ */
+HIDDEN int sys66_getProcInfo(int pid, procinfo_PTR info) {
+	pcb_PTR p = findPid(pid);
+	cpu_t now, slice = 0;
+
+	if(p == NULL)
+		return FAILURE;
+
+	if(p == curProc) {
+		/* Include this SYSCALL so far, as GETCPUTIME does */
+		STCK(now);
+		slice = now - startTOD;
+		info->pi_state = PROCRUNNING;
+
+	} else if(p->p_waitCount > 0 || p->p_waits[0].w_semAdd != NULL) {
+		/* A queued wait node means it sits in the ASL */
+		info->pi_state = PROCBLOCKED;
+
+	} else {
+		info->pi_state = PROCREADY;
+	}
+
+	info->pi_pid = p->p_pid;
+	info->pi_parent = (p->p_prnt == NULL) ? NOPID : p->p_prnt->p_pid;
+	info->pi_CPUTime = p->p_CPUTime + slice;
+	info->pi_kernTime = p->p_kernTime + slice;
+	return SUCCESS;
+}
+
+/*
+ * Waits for a child, or one specific child, to terminate and collects
+ * its exit code: what it passed to EXITPROCESS, EXITNORMAL for
+ * TERMINATEPROCESS, or EXITKILLED / EXITTRAPPED. Exits that happened
+ * earlier are collected at once, oldest first; only the last
+ * MAXEXITRECS are remembered.
+ *
+ * EX: int SYSCALL (JOIN, int pid, int *exitCode)
+ *    Where the mnemonic constant JOIN has the value of 68.
+ * PARAM: a1 = PID of the child, or ANYCHILD
+ *        a2 = address to store the exit code at, or 0
+ * RETURN: v0 = PID of the child that ended, FAILURE if pid is not a
+ *         child of the caller or there is no child left to wait for
+ */
+HIDDEN int sys68_join(int pid, int* exitCode) {
+	int i, j;
+	pcb_PTR child;
+
+	/* Collect an exit already on record */
+	for(i = 0; i < curProc->p_exitCount; i++) {
+		if(pid == ANYCHILD || curProc->p_exits[i].e_pid == pid) {
+			pid = curProc->p_exits[i].e_pid;
+			if(exitCode != 0)
+				*exitCode = curProc->p_exits[i].e_code;
+
+			for(j = i + 1; j < curProc->p_exitCount; j++) {
+				curProc->p_exits[j - 1] = curProc->p_exits[j];
+			}
+			curProc->p_exitCount--;
+			return pid;
+		}
+	}
+
+	/* Anyone to wait for? */
+	if(pid == ANYCHILD) {
+		if(emptyChild(curProc))
+			return FAILURE;
+	} else {
+		child = findPid(pid);
+		if(child == NULL || child->p_prnt != curProc)
+			return FAILURE;
+	}
+
+	curProc->p_joinPid = pid;
+	if(insertBlocked(&(curProc->p_joinSem), curProc))
+		return FAILURE;
+
+	parkCurProc();
+	return FAILURE; /* Not reached, v0 is set by reportExit */
+}
+
+/*
+ * Creates up to n children at once from one template state, e.g. a
+ * worker pool. Child i starts with the template's state except that
+ * its stack pointer is i * stackStride lower and a0 holds i, so the
+ * entry point receives its index as its first argument.
+ *
+ * The pcbs come off the free list as one run, and are hooked into the
+ * process tree and onto the ready queue with one splice each.
+ *
+ * EX: int SYSCALL (SPAWNMANY, state_t *statep, int n, int stackStride)
+ *    Where the mnemonic constant SPAWNMANY has the value of 69.
+ * PARAM: a1 = physical address of the template processor state
+ *        a2 = n
+ *        a3 = bytes of stack between consecutive children
+ * RETURN: v0 = number of children created, fewer than n if the pcbs
+ *         ran out
+ */
+HIDDEN int sys69_spawnMany(state_PTR birthState, int n, int stackStride) {
+	pcb_PTR brood = allocPcbs(n);
+	pcb_PTR child;
+	int born = 0;
+
+	if(emptyProcQ(brood))
+		return 0;
+
+	child = brood;
+	do {
+		child = child->p_next;
+		copyState(birthState, &(child->p_s));
+		child->p_s.s_sp = birthState->s_sp - (born * stackStride);
+		child->p_s.s_a0 = born;
+		born++;
+	} while(child != brood);
+
+	insertChildren(curProc, brood);
+	mergeProcQ(&deathRowLine, brood);
+	procCount += born;
+	return born;
+}
+
+/*
+ * Closes a pipe for writing, the writer's end of stream. Blocked
+ * readers get what is left, however short, then 0; blocked writers
+ * and later PIPEWRITEs get FAILURE. PIPEDESTROY still frees the pipe.
+ *
+ * EX: int SYSCALL (PIPECLOSE, int id)
+ *    Where the mnemonic constant PIPECLOSE has the value of 70.
+ * PARAM: a1 = id of the pipe
+ * RETURN: v0 = SUCCESS, FAILURE for a bad id
+ */
+HIDDEN int sys70_pipeClose(int id) {
+	pipe_PTR pp = findPipe(id);
+
+	if(pp == NULL)
+		return FAILURE;
+
+	pp->pp_closed = TRUE;
+	releaseAll(&(pp->pp_writeSem), FAILURE);
+	pp->pp_writeSem = 0;
+
+	settlePipe(pp);
+	releaseAll(&(pp->pp_readSem), 0);
+	pp->pp_readSem = 0;
+	return SUCCESS;
+}
+
+/*
+ * isNucleusCall - Decides whether a SYSCALL number is serviced by the
+ *   nucleus (and therefore privileged) or passed up
+ * RETURN: TRUE for SYS1-SYS8 and the extended nucleus calls
+ */
+HIDDEN Bool isNucleusCall(int sysNum) {
+	return (sysNum > 0 && sysNum <= WAITIO) ||
+		(sysNum >= GETCPUTIMES && sysNum <= LASTNUCSYSCALL);
 }
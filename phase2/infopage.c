@@ -0,0 +1,70 @@
+/********************** INFOPAGE.C ***************************
+ *
+ * Info page library for Kaya OS processes
+ *
+ * GETCPUTIME costs a full exception just to read a clock. The
+ * nucleus instead keeps a kinfo_t up to date every time it
+ * (re)starts a process; after one GETINFOPAGE to find it, these
+ * routines work out the time of day and the caller's CPU time
+ * from the page and the TOD clock with no SYSCALL at all.
+ *
+ * The page is consistent when the caller resumed, and it can only
+ * change while the caller is off the processor, so a read that
+ * saw ki_gen unchanged (and even) on both sides is consistent.
+ *
+ * Reading the TOD register needs kernel mode, as all phase 2
+ * processes run; a user mode process has to trap for the time.
+ *
+ * AUTHORS: Ploy Sithisakulrat & Gavin Kyte
+ * ADVISOR/CONTRIBUTER: Michael Goldweber
+ *************************************************************/
+
+#include "../h/const.h"
+#include "../h/types.h"
+
+#include "../e/infopage.e"
+#include "/usr/local/include/umps2/umps/libumps.e"
+
+/************************* Prototypes ************************/
+HIDDEN cpu_t readTOD(kinfo_PTR k);
+
+/********************** External Methods *********************/
+/*
+ * infoPage - Find the info page; the only SYSCALL, do it once
+ * RETURN: address of the kernel's kinfo_t
+ */
+kinfo_PTR infoPage() {
+	return (kinfo_PTR) SYSCALL(GETINFOPAGE, 0, 0, 0);
+}
+
+/*
+ * infoTOD - The time of day, in μ seconds, as STCK reports it
+ */
+cpu_t infoTOD(kinfo_PTR k) {
+	return readTOD(k);
+}
+
+/*
+ * infoCPUTime - The caller's processor time, as GETCPUTIME reports
+ *   it: what it had when last resumed plus the time since
+ */
+cpu_t infoCPUTime(kinfo_PTR k) {
+	int gen;
+	cpu_t used, now;
+
+	do {
+		gen = k->ki_gen;
+		used = k->ki_CPUTime;
+		now = readTOD(k) - k->ki_TOD;
+	} while((gen & 1) || gen != k->ki_gen);
+
+	return used + now;
+}
+
+/********************** Helper Methods ***********************/
+/*
+ * readTOD - Read the TOD clock scaled to μ seconds, like STCK
+ */
+HIDDEN cpu_t readTOD(kinfo_PTR k) {
+	return *((cpu_t*) TODLOADDR) / k->ki_timeScale;
+}
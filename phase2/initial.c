@@ -23,14 +23,23 @@
 #include "../e/scheduler.e"
 #include "../e/interrupts.e"
 #include "../e/exceptions.e"
+#include "../e/semprof.e"
+#include "../e/pipe.e"
 #include "/usr/local/include/umps2/umps/libumps.e"
 
 extern void test(); /* To link OS's 1st process to test file location */
 
 int procCount, softBlkCount, semaphores[MAXSEMS];
+iostat_t ioStats[DEVSEMNUM]; /* WAITIO latency per device sema4 */
+pcb_PTR ringOwner[DEVSEMNUM]; /* process whose ring takes the completions */
+unsigned int devStatus[DEVSEMNUM]; /* status of each device's last completion */
 int *psuedoClock; /* a semaphore */
 Bool waiting;
-cpu_t startTOD;
+cpu_t startTOD; /* start of the slice being metered, see chargeCurProc */
+cpu_t bootTOD, idleTime, interTime; /* system-wide utilization meters */
+cpu_t nextTickTOD; /* absolute deadline of the next pseudo-clock tick */
+clockstat_t clockStats;
+kinfo_t kernInfo; /* the info page, see scheduler's loadState */
 pcb_PTR curProc;
 pcb_PTR deathRowLine; /* Queue of non-blocked jobs to be executed */
 
@@ -43,9 +52,21 @@ pcb_PTR deathRowLine; /* Queue of non-blocked jobs to be executed */
  * RETURN: int* calculated address of device semaphore
  */
 int* findSem(int lineNum, int deviceNum, Bool isReadTerm) {
-	int termOffset = (isReadTerm) ? 1 : 0;
-	int semGroup = (lineNum - LINENUMOFFSET) + termOffset;
-	return &(semaphores[semGroup * DEVPERINT + deviceNum]);
+	return &(semaphores[DEVSEMINDEX(lineNum, deviceNum, isReadTerm)]);
+}
+
+/*
+ * logLatency - Counts one sample in a log2 latency histogram
+ * PARAM: int hist[] has IOHISTBUCKETS buckets, see iostat_t
+ *        cpu_t elapsed is the sample in microseconds
+ */
+void logLatency(int hist[], cpu_t elapsed) {
+	int bucket = 0;
+
+	while(bucket < IOHISTBUCKETS - 1 && elapsed >= (IOHISTBASE << bucket))
+		bucket++;
+
+	hist[bucket]++;
 }
 
 /*
@@ -54,7 +75,7 @@ int* findSem(int lineNum, int deviceNum, Bool isReadTerm) {
  * Only runs once. Scheduler takes control after this method
  */
 int main() {
-	int i;
+	int i, j;
 	unsigned int ramtop, baseStatus;
 	devregarea_t* devregarea;
 	state_PTR intNewArea, tlbMgntNewArea, pgrmTrpNewArea, sysCallNewArea;
@@ -68,6 +89,19 @@ int main() {
 
 	psuedoClock = &(semaphores[MAXSEMS - 1]);
 
+	for(i = 0; i < DEVSEMNUM; i++) {
+		ringOwner[i] = NULL;
+		devStatus[i] = 0;
+		ioStats[i].io_count = 0;
+		ioStats[i].io_maxWaiters = 0;
+		ioStats[i].io_sumService = ioStats[i].io_maxService = 0;
+		ioStats[i].io_sumWakeup = ioStats[i].io_maxWakeup = 0;
+		for(j = 0; j < IOHISTBUCKETS; j++) {
+			ioStats[i].io_serviceHist[j] = 0;
+			ioStats[i].io_wakeupHist[j] = 0;
+		}
+	}
+
 	/* Get ROM defined hardware info */
 	devregarea = (devregarea_t*) RAMBASEADDR;
 	ramtop = (devregarea->rambase) + (devregarea->ramsize);
@@ -95,6 +129,8 @@ int main() {
 
 	initPCBs(); /* initialize ProcBlk Queue */
 	initASL(); /* Initialize Active Semaphore List */
+	initSemProf(); /* Start with an empty contention profile */
+	initPipes();
 
 	/* initialize Phase 2 global variables */
 	procCount = 0;
@@ -114,8 +150,24 @@ int main() {
 	firstP->p_s.s_pc = firstP->p_s.s_t9 = (memaddr) test;
 
 	waiting = FALSE;
+	idleTime = 0;
+	interTime = 0;
+	clockStats.ck_ticks = 0;
+	clockStats.ck_missed = 0;
+	clockStats.ck_minJitter = 0;
+	clockStats.ck_maxJitter = 0;
+	clockStats.ck_avgJitter = 0;
+	clockStats.ck_sumJitter = 0;
+	kernInfo.ki_gen = 0;
+	kernInfo.ki_timeScale = *((cpu_t*) TIMESCALEADDR);
+	kernInfo.ki_TOD = 0;
+	kernInfo.ki_CPUTime = 0;
 	procCount++;
 	putInPool(firstP);
+
+	/* Lay down the pseudo-clock's tick grid from boot */
+	STCK(bootTOD);
+	nextTickTOD = bootTOD + INTERVALTIME;
 	LDIT(INTERVALTIME);
 	nextVictim();
 	return 0; /* Will never reach, but this removes the warning */
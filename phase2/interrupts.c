@@ -36,6 +36,7 @@
 #include "../e/initial.e"
 #include "../e/scheduler.e"
 #include "../e/exceptions.e"
+#include "../e/semprof.e"
 #include "/usr/local/include/umps2/umps/libumps.e"
 
 /************************* Prototypes ************************/
@@ -46,17 +47,21 @@ HIDDEN int findDeviceIndex(int intLine);
 HIDDEN int findLineIndex(unsigned int causeRegister);
 HIDDEN unsigned int handleTerminal(device_t* device);
 HIDDEN Bool isReadTerm(int lineNum, device_t* dev);
+HIDDEN void nextTick(cpu_t tickTOD);
+HIDDEN void logServiceTime(pcb_PTR p, cpu_t doneTOD);
+HIDDEN void postCompletion(pcb_PTR owner, int lineNum, int deviceNum,
+	Bool isRead, unsigned int status, cpu_t doneTOD);
 
 /********************** External Methods *********************/
 /*
  * intHandler - the entry point method to respond to device
  *   interrupts. This executes atomically in kernal mode
  *
- * Note on timing: if time spent here is the "fault" of a
- *   process, attribute only that much to it. Things like the
- *   psuedo clock tick are hardware/system initiated, so only
- *   the time spent releasing a blocked job is saved, not the
- *   clock tick handling.
+ * Note on timing: the interrupted process is billed up to the
+ *   moment the interrupt arrived and no further. Handling the
+ *   interrupt (clock ticks, releasing blocked jobs, ACKs) is
+ *   system work and accumulates in interTime; if the processor
+ *   was WAITing, the wait is added to idleTime instead.
  *
  * RETURN: v0 of the waiting process will have status update
  *   or a new process will be scheduled to execute
@@ -64,7 +69,7 @@ HIDDEN Bool isReadTerm(int lineNum, device_t* dev);
 void intHandler() {
 	Bool isRead;
 	pcb_PTR p;
-	cpu_t stopTOD, endOfInterrupt, tmpTOD;
+	cpu_t stopTOD, endOfInterrupt;
 	state_PTR oldInt;
 	device_t* device;
 	unsigned int status;
@@ -75,43 +80,48 @@ void intHandler() {
 	oldInt = (state_PTR) INTOLDAREA;
 	lineNumber = findLineIndex(oldInt->s_cause);
 
+	if(waiting) {
+		/* nextVictim started the meter when it went to WAIT */
+		idleTime += stopTOD - startTOD;
+
+	} else if(curProc != NULL) {
+		/* Close the interrupted process's slice, keep startTOD for quantum */
+		curProc->p_CPUTime += stopTOD - startTOD;
+	}
+
 	if(lineNumber == 0) { /* Handle inter-processor interrupt (not now) */
 		gameOver(INTER);
 
 	} else if(lineNumber == 1) { /* Handle Local Timer (End QUANTUMTIME) */
-		curProc->p_CPUTime += stopTOD - startTOD; /* ~ a QUANTUMTIME */
 		copyState(oldInt, &(curProc->p_s)); /* Save for reentry */
 
 		putInPool(curProc);
-		curProc = NULL;
-		nextVictim();
+		curProc = NULL; /* nextVictim is chosen below */
 
 	} else if(lineNumber == 2) { /* Handle Interval Timer */
 		/* Release all jobs from psuedoClock */
 		(*psuedoClock)++;
+		profV(psuedoClock);
 
 		if((*psuedoClock) <= 0) {
 
 			while(headBlocked(psuedoClock) != NULL) {
-				STCK(tmpTOD);
-
 				putInPool(p = removeBlocked(psuedoClock));
+				profWake(p, stopTOD);
 				softBlkCount--;
 
-				STCK(endOfInterrupt);
-				/* Account for time spent */
-				p->p_CPUTime += (tmpTOD - endOfInterrupt);
+				if(p->p_waitCount > 0)
+					wakeWaitAny(p);
 			}
 		}
 
 		(*psuedoClock) = 0;
-		LDIT(INTERVALTIME);
+		nextTick(stopTOD);
 
 	} else { /* lineNumber >= 3; Handle I/O device interrupt */
 		/*
 		 * Be aware that I/O int can occur BEFORE sys8_waitForIODevice
-		 * We do not explicitly handle this case,
-		 * because it is a concern in phase 2
+		 * The status is kept in devStatus for the late WAITIO
 		 */
 
 		/* Get device meta data */
@@ -120,22 +130,37 @@ void intHandler() {
 		isRead = isReadTerm(lineNumber, device); /* Could avoid call */
 		status = ack(lineNumber, device);
 
-		/* V the dev's sema4, once io complete, put back on death row */
 		semAdd = findSem(lineNumber, deviceNumber, isRead);
-		(*semAdd)++;
 
-		if((*semAdd) <= 0) {
-			putInPool(p = removeBlocked(semAdd));
-			softBlkCount--;
-			p->p_s.s_v0 = status;
+		if(ringOwner[semAdd - semaphores] != NULL) {
+			/* Async device: its owner reaps completions from a ring */
+			postCompletion(ringOwner[semAdd - semaphores], lineNumber,
+				deviceNumber, isRead, status, stopTOD);
 
-			STCK(endOfInterrupt);
-			/* Account for time spent */
-			p->p_CPUTime += (stopTOD - endOfInterrupt);
+		} else {
+			/* V the dev's sema4, once io complete, put back on death row */
+			devStatus[semAdd - semaphores] = status;
+			(*semAdd)++;
+			profV(semAdd);
+
+			if((*semAdd) <= 0) {
+				putInPool(p = removeBlocked(semAdd));
+				profWake(p, stopTOD);
+				softBlkCount--;
+				logServiceTime(p, stopTOD);
+
+				if(p->p_waitCount > 0)
+					wakeWaitAny(p); /* v0 is the index, v1 the status */
+				else
+					p->p_s.s_v0 = status;
+			}
 		}
 	}
 
-	/* General non-accounted time space belongs to OS, not any process */
+	/* Time spent in here belongs to the system, not any process */
+	STCK(endOfInterrupt);
+	interTime += endOfInterrupt - stopTOD;
+
 	if(waiting || curProc == NULL) {
 		/* Came back from waiting, get next job; don't return to WAIT */
 		waiting = FALSE;
@@ -253,6 +278,99 @@ HIDDEN unsigned int handleTerminal(device_t* device) {
 	return status;
 }
 
+/*
+ * postCompletion - Appends a completion record to the owner's async I/O
+ *   ring instead of V'ing the device sema4. If the owner is blocked in
+ *   IOWAITANY it is released with the number of entries ready in v0.
+ *
+ * PARAM: owner bound the device with IOBIND; the rest describe the
+ *        completion as WAITIO would have reported it
+ */
+HIDDEN void postCompletion(pcb_PTR owner, int lineNum, int deviceNum,
+		Bool isRead, unsigned int status, cpu_t doneTOD) {
+	ioring_PTR ring = owner->p_ioRing;
+	iocomp_t* entry;
+	pcb_PTR p;
+	int next = (owner->p_ioTail + 1) % IORINGSIZE;
+
+	if(next == ring->r_head || ring->r_head < 0 ||
+			ring->r_head >= IORINGSIZE) {
+		ring->r_dropped++; /* Full, or the owner garbled r_head */
+
+	} else {
+		entry = &(ring->r_entries[owner->p_ioTail]);
+		entry->c_line = lineNum;
+		entry->c_dev = deviceNum;
+		entry->c_isRead = isRead;
+		entry->c_status = status;
+		entry->c_tod = doneTOD;
+		owner->p_ioTail = next;
+	}
+	ring->r_tail = owner->p_ioTail;
+
+	if((p = removeBlocked(&(ring->r_tail))) != NULL) {
+		p->p_s.s_v0 = ringCount(p);
+		putInPool(p);
+		softBlkCount--;
+	}
+}
+
+/*
+ * logServiceTime - Logs how long p sat blocked in WAITIO before its
+ *   device completed, then restamps p so nextVictim can log how long
+ *   it waits on the ready queue before it actually runs.
+ *
+ * PARAM: p was just released from its device sema4 at doneTOD
+ */
+HIDDEN void logServiceTime(pcb_PTR p, cpu_t doneTOD) {
+	iostat_PTR stats;
+	cpu_t service;
+
+	if(p->p_ioSlot == NOIOSLOT)
+		return;
+
+	stats = &(ioStats[p->p_ioSlot]);
+	service = doneTOD - p->p_ioTOD;
+	stats->io_count++;
+	stats->io_sumService += service;
+	stats->io_maxService = MAX(stats->io_maxService, service);
+	logLatency(stats->io_serviceHist, service);
+
+	p->p_ioTOD = doneTOD;
+}
+
+/*
+ * nextTick - Records how late this pseudo-clock tick fired and re-arms
+ *   the Interval Timer for the next absolute deadline, so the handler's
+ *   own latency never accumulates as drift. Deadlines that already
+ *   passed are counted as missed and skipped whole, which keeps every
+ *   tick on the INTERVALTIME grid laid down at boot.
+ *
+ * PARAM: tickTOD is when the interval interrupt was taken
+ */
+HIDDEN void nextTick(cpu_t tickTOD) {
+	cpu_t jitter, now;
+
+	jitter = tickTOD - nextTickTOD;
+	if(clockStats.ck_ticks == 0 || jitter < clockStats.ck_minJitter)
+		clockStats.ck_minJitter = jitter;
+	if(clockStats.ck_ticks == 0 || jitter > clockStats.ck_maxJitter)
+		clockStats.ck_maxJitter = jitter;
+	clockStats.ck_sumJitter += jitter;
+	clockStats.ck_ticks++;
+	clockStats.ck_avgJitter = clockStats.ck_sumJitter / clockStats.ck_ticks;
+
+	/* Catch up on whole intervals, never re-phase the grid */
+	nextTickTOD += INTERVALTIME;
+	STCK(now);
+	while(nextTickTOD <= now) {
+		nextTickTOD += INTERVALTIME;
+		clockStats.ck_missed++;
+	}
+
+	LDIT(nextTickTOD - now);
+}
+
 /*
  * isReadTerm - Decides whether interrupting device is a terminal
  * and whether it should be treated as a read (TRUE) or write (FALSE) terminal
@@ -0,0 +1,407 @@
+/*********************************P2BENCH.C*****************************
+ *
+ *	Micro-benchmarks for the Kaya nucleus extensions: phase 2.
+ *
+ *	Linked in place of p2test.o by "make bench"; the root process
+ *	times each workload with the TOD clock and GETCPUTIMES and
+ *	reports on Terminal0, then terminates so the nucleus HALTs.
+ *
+ *	The round-trip and pipe workloads talk to helper processes,
+ *	children of the root that die with it; their wall times include
+ *	the helper's side.
+ *
+ *	Every workload is timed as a whole, so figures include the odd
+ *	pseudo-clock tick or quantum end; compare runs, not single ops.
+ *
+ * AUTHORS: Ploy Sithisakulrat & Gavin Kyte
+ * ADVISOR/CONTRIBUTER: Michael Goldweber
+ */
+
+#include "../h/const.h"
+#include "../h/types.h"
+#include "../e/infopage.e"
+#include "/usr/local/include/umps2/umps/libumps.e"
+
+typedef unsigned int devregtr;
+
+/* hardware constants */
+#define PRINTCHR		2
+#define BYTELEN			8
+#define RECVD			5
+#define TERMSTATMASK	0xFF
+#define	TERM0ADDR		0x10000250
+
+#define QPAGE			1024
+#define IEPBITON		0x4
+#define CAUSEINTMASK	0xFC00
+
+/* system call codes */
+#define	CREATETHREAD	1
+#define	TERMINATETHREAD	2
+#define	PASSERN			4
+
+#define SEMAPHORE		int
+#define BENCHOPS		1024	/* operations per workload */
+#define BATCHSIZE		16		/* operations per BATCHOPS call */
+#define DIGITS			12
+#define ROUNDTRIPS		256		/* request/reply exchanges per workload */
+#define STREAMBYTES		4096	/* bytes pushed through the pipe */
+#define CHUNK			64		/* bytes per PIPEWRITE */
+#define POOLSIZE		8		/* workers per pool */
+#define POOLROUNDS		16		/* pools started and joined */
+
+SEMAPHORE term_mut=1,	/* for mutual exclusion on terminal */
+		benchsem=0,		/* sema4 the workloads hammer on */
+		serverup=0,		/* V'd once the echo servers have started */
+		reqsem=0,		/* request posted for the sema4 echo server */
+		repsem=0;		/* reply posted by the sema4 echo server */
+
+batchop_t batch[BATCHSIZE];
+state_t semserverstate, ipcserverstate, producerstate, workerstate;
+int request, reply;		/* mailbox of the sema4 echo server */
+int ipcserver;			/* handle of the IPC echo server */
+int pipeid;				/* pipe from the producer to the root */
+char outbuf[CHUNK], inbuf[PIPESIZE];
+
+/* a procedure to print on terminal 0 */
+void print(char *msg) {
+	char * s = msg;
+	devregtr * base = (devregtr *) (TERM0ADDR);
+	devregtr status;
+
+	SYSCALL(PASSERN, (int)&term_mut, 0, 0);
+	while (*s != EOS) {
+		*(base + 3) = PRINTCHR | (((devregtr) *s) << BYTELEN);
+		status = SYSCALL(WAITIO, TERMINT, 0, 0);
+		if ((status & TERMSTATMASK) != RECVD)
+			PANIC();
+		s++;
+	}
+	SYSCALL(VERHOGEN, (int)&term_mut, 0, 0);
+}
+
+/* print a non-negative number in decimal */
+void printNum(int n) {
+	char buf[DIGITS];
+	int i = DIGITS - 1;
+
+	buf[i] = EOS;
+	do {
+		buf[--i] = '0' + (n % 10);
+		n = n / 10;
+	} while (n > 0 && i > 0);
+
+	print(&buf[i]);
+}
+
+/* one line of results: wall and kernel time per 100 operations */
+void report(char *label, cpu_t wall, cpu_t kernel, int ops) {
+	print(label);
+	print(": ");
+	printNum((wall * 100) / ops);
+	print(" us wall, ");
+	printNum((kernel * 100) / ops);
+	print(" us kernel per 100 ops\n");
+}
+
+/* V benchsem BENCHOPS times, one SYSCALL per V */
+void singleV() {
+	cpu_t t1, t2;
+	cputime_t c1, c2;
+	int i;
+
+	SYSCALL(GETCPUTIMES, (int)&c1, 0, 0);
+	STCK(t1);
+	for (i = 0; i < BENCHOPS; i++)
+		SYSCALL(VERHOGEN, (int)&benchsem, 0, 0);
+	STCK(t2);
+	SYSCALL(GETCPUTIMES, (int)&c2, 0, 0);
+
+	report("single V", t2 - t1, c2.c_kernel - c1.c_kernel, BENCHOPS);
+}
+
+/* V benchsem BENCHOPS times, BATCHSIZE V's per SYSCALL */
+void batchedV() {
+	cpu_t t1, t2;
+	cputime_t c1, c2;
+	int i;
+
+	for (i = 0; i < BATCHSIZE; i++) {
+		batch[i].b_op = VERHOGEN;
+		batch[i].b_arg = (int)&benchsem;
+	}
+
+	SYSCALL(GETCPUTIMES, (int)&c1, 0, 0);
+	STCK(t1);
+	for (i = 0; i < BENCHOPS; i += BATCHSIZE)
+		SYSCALL(BATCHOPS, (int)batch, BATCHSIZE, 0);
+	STCK(t2);
+	SYSCALL(GETCPUTIMES, (int)&c2, 0, 0);
+
+	report("batched V", t2 - t1, c2.c_kernel - c1.c_kernel, BENCHOPS);
+}
+
+/* take back the V's with batched P's, checking none would block */
+void batchedP() {
+	cpu_t t1, t2;
+	cputime_t c1, c2;
+	int i, ops = 0;
+
+	for (i = 0; i < BATCHSIZE; i++)
+		batch[i].b_op = PASSERN;
+
+	SYSCALL(GETCPUTIMES, (int)&c1, 0, 0);
+	STCK(t1);
+	while (benchsem >= BATCHSIZE)
+		ops += SYSCALL(BATCHOPS, (int)batch, BATCHSIZE, 0);
+	STCK(t2);
+	SYSCALL(GETCPUTIMES, (int)&c2, 0, 0);
+
+	if (ops != 2 * BENCHOPS)
+		print("error: batched P's stopped early\n");
+
+	report("batched P", t2 - t1, c2.c_kernel - c1.c_kernel, ops);
+
+	/* the next P would block; the batch must stop in front of it */
+	if (SYSCALL(BATCHOPS, (int)batch, BATCHSIZE, 0) != 0 ||
+			batch[0].b_result != BATCHWOULDBLOCK)
+		print("error: batched P did not stop before blocking\n");
+}
+
+/* echo server for semRoundTrip: shared mailbox guarded by two sema4s */
+void semServer() {
+	SYSCALL(VERHOGEN, (int)&serverup, 0, 0);
+	while (TRUE) {
+		SYSCALL(PASSERN, (int)&reqsem, 0, 0);
+		reply = request + 1;
+		SYSCALL(VERHOGEN, (int)&repsem, 0, 0);
+	}
+}
+
+/* echo server for ipcRoundTrip */
+void ipcServer() {
+	msg_t m;
+	int client;
+
+	ipcserver = SYSCALL(GETPID, 0, 0, 0);
+	SYSCALL(VERHOGEN, (int)&serverup, 0, 0);
+	while (TRUE) {
+		client = SYSCALL(RECV, ANYSENDER, (int)&m, 0);
+		SYSCALL(REPLY, client, m.m_w0 + 1, 0);
+	}
+}
+
+/* start an echo server running f on a stack below ours */
+void startServer(state_t *s, memaddr f, int stackOffset) {
+	STST(s);
+	s->s_sp = s->s_sp - stackOffset;
+	s->s_pc = s->s_t9 = f;
+	s->s_status = s->s_status | IEPBITON | CAUSEINTMASK;
+	SYSCALL(CREATETHREAD, (int)s, 0, 0);
+	SYSCALL(PASSERN, (int)&serverup, 0, 0);
+}
+
+/* request/reply through the mailbox: four SYSCALLs per exchange */
+void semRoundTrip() {
+	cpu_t t1, t2;
+	cputime_t c1, c2;
+	int i;
+
+	SYSCALL(GETCPUTIMES, (int)&c1, 0, 0);
+	STCK(t1);
+	for (i = 0; i < ROUNDTRIPS; i++) {
+		request = i;
+		SYSCALL(VERHOGEN, (int)&reqsem, 0, 0);
+		SYSCALL(PASSERN, (int)&repsem, 0, 0);
+		if (reply != i + 1)
+			print("error: sema4 echo server gave a wrong reply\n");
+	}
+	STCK(t2);
+	SYSCALL(GETCPUTIMES, (int)&c2, 0, 0);
+
+	report("sema4 round trip", t2 - t1, c2.c_kernel - c1.c_kernel, ROUNDTRIPS);
+}
+
+/* request/reply with CALL: one SYSCALL per exchange on our side */
+void ipcRoundTrip() {
+	cpu_t t1, t2;
+	cputime_t c1, c2;
+	int i;
+
+	SYSCALL(GETCPUTIMES, (int)&c1, 0, 0);
+	STCK(t1);
+	for (i = 0; i < ROUNDTRIPS; i++) {
+		if (SYSCALL(CALL, ipcserver, i, 0) != i + 1)
+			print("error: IPC echo server gave a wrong reply\n");
+	}
+	STCK(t2);
+	SYSCALL(GETCPUTIMES, (int)&c2, 0, 0);
+
+	report("IPC round trip", t2 - t1, c2.c_kernel - c1.c_kernel, ROUNDTRIPS);
+}
+
+/* writes STREAMBYTES into the pipe, CHUNK bytes per call */
+void producer() {
+	int i, sent = 0, n;
+
+	for (i = 0; i < CHUNK; i++)
+		outbuf[i] = (char) i;
+
+	SYSCALL(VERHOGEN, (int)&serverup, 0, 0);
+	while (sent < STREAMBYTES) {
+		n = SYSCALL(PIPEWRITE, pipeid, (int)outbuf, CHUNK);
+		if (n <= 0)
+			print("error: PIPEWRITE failed\n");
+		sent += n;
+	}
+
+	SYSCALL(PASSERN, (int)&benchsem, 0, 0); /* park until the root is done */
+}
+
+/* drain the producer's stream; reports bytes per PIPEREAD */
+void pipeStream() {
+	cpu_t t1, t2;
+	cputime_t c1, c2;
+	int got = 0, reads = 0, n;
+
+	SYSCALL(GETCPUTIMES, (int)&c1, 0, 0);
+	STCK(t1);
+	while (got < STREAMBYTES) {
+		n = SYSCALL(PIPEREAD, pipeid, (int)inbuf, PIPESIZE);
+		if (n <= 0) {
+			print("error: PIPEREAD failed\n");
+			break;
+		}
+		got += n;
+		reads++;
+	}
+	STCK(t2);
+	SYSCALL(GETCPUTIMES, (int)&c2, 0, 0);
+
+	report("pipe stream (per 100 bytes)", t2 - t1, c2.c_kernel - c1.c_kernel,
+		STREAMBYTES);
+	print("pipe stream: ");
+	printNum(STREAMBYTES / reads);
+	print(" bytes per PIPEREAD\n");
+}
+
+/* CPU time BENCHOPS times with GETCPUTIME, then off the info page */
+void cpuTimeReads() {
+	cpu_t t1, t2, t3, prev, now;
+	cputime_t c1, c2, c3;
+	kinfo_PTR k = infoPage();
+	int i;
+
+	SYSCALL(GETCPUTIMES, (int)&c1, 0, 0);
+	STCK(t1);
+	for (i = 0; i < BENCHOPS; i++)
+		SYSCALL(GETCPUTIME, 0, 0, 0);
+	STCK(t2);
+	SYSCALL(GETCPUTIMES, (int)&c2, 0, 0);
+
+	prev = infoCPUTime(k);
+	for (i = 0; i < BENCHOPS; i++) {
+		now = infoCPUTime(k);
+		if (now < prev)
+			print("error: info page CPU time went backwards\n");
+		prev = now;
+	}
+	STCK(t3);
+	SYSCALL(GETCPUTIMES, (int)&c3, 0, 0);
+
+	report("GETCPUTIME", t2 - t1, c2.c_kernel - c1.c_kernel, BENCHOPS);
+	report("info page CPU time", t3 - t2, c3.c_kernel - c2.c_kernel,
+		BENCHOPS);
+}
+
+/* a pool worker: exits at once, with its index as exit code */
+void worker(int index) {
+	SYSCALL(EXITPROCESS, index, 0, 0);
+}
+
+/* collect a whole pool, checking every index came back once */
+void joinPool() {
+	int i, code, seen = 0;
+
+	for (i = 0; i < POOLSIZE; i++) {
+		if (SYSCALL(JOIN, ANYCHILD, (int)&code, 0) == FAILURE)
+			print("error: JOIN found no worker\n");
+		seen |= 1 << code;
+	}
+
+	if (seen != (1 << POOLSIZE) - 1)
+		print("error: JOIN returned wrong exit codes\n");
+}
+
+/* start and join POOLROUNDS pools, one CREATETHREAD per worker */
+void createPools() {
+	cpu_t t1, t2;
+	cputime_t c1, c2;
+	int r, i;
+
+	SYSCALL(GETCPUTIMES, (int)&c1, 0, 0);
+	STCK(t1);
+	for (r = 0; r < POOLROUNDS; r++) {
+		for (i = 0; i < POOLSIZE; i++) {
+			workerstate.s_a0 = i;
+			SYSCALL(CREATETHREAD, (int)&workerstate, 0, 0);
+			workerstate.s_sp -= QPAGE;
+		}
+		workerstate.s_sp += POOLSIZE * QPAGE;
+		joinPool();
+	}
+	STCK(t2);
+	SYSCALL(GETCPUTIMES, (int)&c2, 0, 0);
+
+	report("CREATETHREAD pool (per 100 workers)", t2 - t1,
+		c2.c_kernel - c1.c_kernel, POOLROUNDS * POOLSIZE);
+}
+
+/* start and join POOLROUNDS pools, one SPAWNMANY per pool */
+void spawnPools() {
+	cpu_t t1, t2;
+	cputime_t c1, c2;
+	int r;
+
+	SYSCALL(GETCPUTIMES, (int)&c1, 0, 0);
+	STCK(t1);
+	for (r = 0; r < POOLROUNDS; r++) {
+		if (SYSCALL(SPAWNMANY, (int)&workerstate, POOLSIZE, QPAGE) != POOLSIZE)
+			print("error: SPAWNMANY came up short\n");
+		joinPool();
+	}
+	STCK(t2);
+	SYSCALL(GETCPUTIMES, (int)&c2, 0, 0);
+
+	report("SPAWNMANY pool (per 100 workers)", t2 - t1,
+		c2.c_kernel - c1.c_kernel, POOLROUNDS * POOLSIZE);
+}
+
+void test() {
+	print("p2bench starts\n");
+
+	singleV();
+	batchedV();
+	batchedP();
+	cpuTimeReads();
+
+	startServer(&semserverstate, (memaddr)semServer, QPAGE);
+	startServer(&ipcserverstate, (memaddr)ipcServer, 2 * QPAGE);
+	semRoundTrip();
+	ipcRoundTrip();
+
+	pipeid = SYSCALL(PIPECREATE, 0, 0, 0);
+	startServer(&producerstate, (memaddr)producer, 3 * QPAGE);
+	pipeStream();
+	SYSCALL(PIPEDESTROY, pipeid, 0, 0);
+
+	STST(&workerstate);
+	workerstate.s_sp = workerstate.s_sp - (4 * QPAGE);
+	workerstate.s_pc = workerstate.s_t9 = (memaddr)worker;
+	workerstate.s_status = workerstate.s_status | IEPBITON | CAUSEINTMASK;
+	createPools();
+	spawnPools();
+
+	print("p2bench finishes\n");
+	SYSCALL(TERMINATETHREAD, 0, 0, 0);
+}
@@ -0,0 +1,122 @@
+/************************ PIPE.C *****************************
+ *
+ * Nucleus pipes for Kaya OS
+ *
+ * A pipe is a PIPESIZE byte ring in kernel memory, so a stream
+ * between two processes moves many bytes per SYSCALL instead of
+ * one P and one V per item. Pipes are named by their index in a
+ * static table of MAXPIPES.
+ *
+ * This module only manages the table and copies bytes in and
+ * out of a ring; blocking and waking readers and writers on the
+ * pipe's sema4s is done by the PIPE SYSCALLs in exceptions.
+ *
+ * AUTHORS: Ploy Sithisakulrat & Gavin Kyte
+ * ADVISOR/CONTRIBUTER: Michael Goldweber
+ *************************************************************/
+
+#include "../h/const.h"
+#include "../h/types.h"
+
+#include "../e/pipe.e"
+
+HIDDEN pipe_t pipeTable[MAXPIPES];
+
+/********************** External Methods *********************/
+/*
+ * initPipes - Mark every pipe unused; called once at boot
+ */
+void initPipes() {
+	int i;
+
+	for(i = 0; i < MAXPIPES; i++) {
+		pipeTable[i].pp_inUse = FALSE;
+	}
+}
+
+/*
+ * allocPipe - Claim an unused pipe and empty it
+ * RETURN: the pipe, or NULL if all MAXPIPES are in use
+ */
+pipe_PTR allocPipe() {
+	int i;
+	pipe_PTR pp;
+
+	for(i = 0; i < MAXPIPES; i++) {
+		pp = &(pipeTable[i]);
+
+		if(!pp->pp_inUse) {
+			pp->pp_inUse = TRUE;
+			pp->pp_head = 0;
+			pp->pp_count = 0;
+			pp->pp_closed = FALSE;
+			pp->pp_readSem = 0;
+			pp->pp_writeSem = 0;
+			return pp;
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * freePipe - Return pp to the table; nobody may be blocked on it
+ */
+void freePipe(pipe_PTR pp) {
+	pp->pp_inUse = FALSE;
+}
+
+/*
+ * findPipe - Accessor from a pipe id to the pipe
+ * RETURN: the pipe, or NULL if id names no pipe in use
+ */
+pipe_PTR findPipe(int id) {
+	if(id < 0 || id >= MAXPIPES || !pipeTable[id].pp_inUse)
+		return NULL;
+
+	return &(pipeTable[id]);
+}
+
+/*
+ * pipeId - The id user code names pp by
+ */
+int pipeId(pipe_PTR pp) {
+	return pp - pipeTable;
+}
+
+/*
+ * pipeIn - Append up to n bytes from buf to pp's ring
+ * RETURN: the number of bytes copied, less than n if the ring filled
+ */
+int pipeIn(pipe_PTR pp, char* buf, int n) {
+	int i, tail;
+
+	n = MIN(n, PIPESIZE - pp->pp_count);
+	tail = (pp->pp_head + pp->pp_count) % PIPESIZE;
+
+	for(i = 0; i < n; i++) {
+		pp->pp_buf[tail] = buf[i];
+		tail = (tail + 1) % PIPESIZE;
+	}
+
+	pp->pp_count += n;
+	return n;
+}
+
+/*
+ * pipeOut - Take up to n bytes from the front of pp's ring into buf
+ * RETURN: the number of bytes copied, less than n if the ring emptied
+ */
+int pipeOut(pipe_PTR pp, char* buf, int n) {
+	int i;
+
+	n = MIN(n, pp->pp_count);
+
+	for(i = 0; i < n; i++) {
+		buf[i] = pp->pp_buf[pp->pp_head];
+		pp->pp_head = (pp->pp_head + 1) % PIPESIZE;
+	}
+
+	pp->pp_count -= n;
+	return n;
+}
@@ -42,15 +42,47 @@ void putInPool(pcb_PTR p) {
 	if(p != NULL)
 		insertProcQ(&deathRowLine, p);
 }
+
+/*
+ * publishInfo - Refresh the info page for curProc, about to resume
+ *   with its meter started at startTOD
+ */
+HIDDEN void publishInfo() {
+	kernInfo.ki_gen++; /* odd: update under way */
+	kernInfo.ki_TOD = startTOD;
+	kernInfo.ki_CPUTime = (curProc == NULL) ? 0 : curProc->p_CPUTime;
+	kernInfo.ki_gen++;
+}
 /*************************** External methods *****************************/
 /*
  * loadState - An abstraction of LDST() to give context info and encapsulation
  */
 void loadState(state_PTR statep) {
 	STCK(startTOD);
+	publishInfo();
 	LDST(statep);
 }
 
+/*
+ * chargeCurProc - Bill curProc for the time since startTOD and restart
+ *   the meter from now. Time spent servicing a SYSCALL is also kept
+ *   apart so user and kernel time can be reported separately.
+ * PARAM: isSysCall is TRUE if the slice was spent inside a SYSCALL
+ */
+void chargeCurProc(Bool isSysCall) {
+	cpu_t now;
+	STCK(now);
+
+	if(curProc != NULL) {
+		curProc->p_CPUTime += now - startTOD;
+
+		if(isSysCall)
+			curProc->p_kernTime += now - startTOD;
+	}
+
+	startTOD = now;
+}
+
 /*
  * gameOver - A wrapper function to provide a psuedo status code
  *   to the PANIC() operation.
@@ -78,6 +110,17 @@ void nextVictim() {
 		/* Prepare state for next job */
 		/* Put time on clock */
 		STCK(startTOD);
+
+		if(curProc->p_ioSlot != NOIOSLOT) {
+			/* Woken by an I/O completion; log how long it waited to run */
+			iostat_PTR stats = &(ioStats[curProc->p_ioSlot]);
+			cpu_t delay = startTOD - curProc->p_ioTOD;
+
+			stats->io_sumWakeup += delay;
+			stats->io_maxWakeup = MAX(stats->io_maxWakeup, delay);
+			logLatency(stats->io_wakeupHist, delay);
+			curProc->p_ioSlot = NOIOSLOT;
+		}
 		setTIMER(QUANTUMTIME);
 		loadState(&(curProc->p_s));
 	}
@@ -91,8 +134,21 @@ void nextVictim() {
 	waiting = TRUE;
 	waitState.s_status = (getSTATUS() | INTMASKOFF | INTcON);
 	setTIMER((int) MAXINT);
+	STCK(startTOD); /* intHandler bills the wait as idleTime */
 
 	/* No ready jobs, so we WAIT for next interrupt */
 	setSTATUS(waitState.s_status); /* turn interrupts on */
 	WAIT();
 }
+
+/*
+ * handOff - Switch straight to p, bypassing the ready queue. p runs out
+ *   the rest of the current quantum, so a chain of hand offs cannot
+ *   starve the jobs on death row.
+ *
+ * Pre: the previous curProc has been billed and queued somewhere
+ */
+void handOff(pcb_PTR p) {
+	curProc = p;
+	loadState(&(curProc->p_s));
+}
@@ -0,0 +1,161 @@
+/********************** SEMPROF.C ***************************
+ *
+ * Semaphore contention profiler for Kaya OS
+ *
+ * Keeps per-semaphore-address statistics for every sema4 the
+ * nucleus P's or V's, device sema4s in semaphores[] and user
+ * sema4s alike: how often it is P'd, how often that P blocks,
+ * how long processes stay blocked on it and how long its queue
+ * grows. GETSEMPROFILE reports the worst offenders.
+ *
+ * Entries live in a bounded, open addressed hash table keyed
+ * on the semaphore address. Entries are never evicted; once the
+ * table is full new sema4s are only counted in semProfDropped.
+ *
+ * The hooks sit at the nucleus' calls to insertBlocked and
+ * removeBlocked rather than in the ASL itself so phase 1 stays
+ * free of nucleus dependencies. Set SEMPROFILING to FALSE in
+ * const to compile the profiler down to no-ops.
+ *
+ * AUTHORS: Ploy Sithisakulrat & Gavin Kyte
+ * ADVISOR/CONTRIBUTER: Michael Goldweber
+ *************************************************************/
+
+#include "../h/const.h"
+#include "../h/types.h"
+
+#include "../e/semprof.e"
+
+HIDDEN semprof_t semProfTable[SEMPROFSIZE];
+int semProfDropped; /* sema4s seen after the table filled up */
+
+/************************* Prototypes ************************/
+HIDDEN semprof_PTR findProfile(int* semAdd);
+
+/********************** External Methods *********************/
+/*
+ * initSemProf - Empty the profile table; called once at boot
+ */
+void initSemProf() {
+	int i;
+
+	for(i = 0; i < SEMPROFSIZE; i++) {
+		semProfTable[i].sp_semAdd = NULL;
+		semProfTable[i].sp_pCount = 0;
+		semProfTable[i].sp_contended = 0;
+		semProfTable[i].sp_vCount = 0;
+		semProfTable[i].sp_sumBlocked = 0;
+		semProfTable[i].sp_maxBlocked = 0;
+		semProfTable[i].sp_maxQueue = 0;
+	}
+
+	semProfDropped = 0;
+}
+
+/*
+ * profP - Count a P on semAdd, called after the sema4 was decremented
+ * PARAM: semAdd is the P'd sema4, a negative value means the caller
+ *        is about to block behind -(*semAdd) - 1 others
+ */
+void profP(int* semAdd) {
+	semprof_PTR prof;
+
+	if(!SEMPROFILING || (prof = findProfile(semAdd)) == NULL)
+		return;
+
+	prof->sp_pCount++;
+
+	if((*semAdd) < 0) {
+		prof->sp_contended++;
+		prof->sp_maxQueue = MAX(prof->sp_maxQueue, -(*semAdd));
+	}
+}
+
+/*
+ * profV - Count a V on semAdd
+ */
+void profV(int* semAdd) {
+	semprof_PTR prof;
+
+	if(!SEMPROFILING || (prof = findProfile(semAdd)) == NULL)
+		return;
+
+	prof->sp_vCount++;
+}
+
+/*
+ * profWake - Charge the time p spent blocked to the sema4 it was
+ *   just removed from. p->p_blockTOD is stamped by blockCurProc.
+ * PARAM: p fresh from removeBlocked, p->p_semAdd still names the sema4
+ *        wakeTOD is the time it was released
+ */
+void profWake(pcb_PTR p, cpu_t wakeTOD) {
+	semprof_PTR prof;
+	cpu_t blocked;
+
+	if(!SEMPROFILING || p == NULL || (prof = findProfile(p->p_semAdd)) == NULL)
+		return;
+
+	blocked = wakeTOD - p->p_blockTOD;
+	prof->sp_sumBlocked += blocked;
+	prof->sp_maxBlocked = MAX(prof->sp_maxBlocked, blocked);
+}
+
+/*
+ * topSemProfiles - Ranks the profiled sema4s by total time blocked
+ *   (most contended P's break ties) and copies out the first n
+ *
+ * PARAM: top is an array with room for n semprof_t's
+ * RETURN: number of entries written to top
+ */
+int topSemProfiles(semprof_PTR top, int n) {
+	int i, j, filled = 0;
+	semprof_PTR prof;
+
+	for(i = 0; i < SEMPROFSIZE && n > 0; i++) {
+		prof = &(semProfTable[i]);
+		if(prof->sp_semAdd == NULL)
+			continue;
+
+		/* Insertion sort into top, dropping whatever falls off the end */
+		j = (filled < n) ? filled++ : n;
+		while(j > 0 && (top[j - 1].sp_sumBlocked < prof->sp_sumBlocked ||
+				(top[j - 1].sp_sumBlocked == prof->sp_sumBlocked &&
+				top[j - 1].sp_contended < prof->sp_contended))) {
+			if(j < n)
+				top[j] = top[j - 1];
+			j--;
+		}
+
+		if(j < n)
+			top[j] = *prof;
+	}
+
+	return filled;
+}
+
+/*********************** Helper Methods **********************/
+/*
+ * findProfile - Locate or claim semAdd's entry by linear probing
+ * RETURN: the entry, or NULL if semAdd is new and the table is full
+ */
+HIDDEN semprof_PTR findProfile(int* semAdd) {
+	int i, slot;
+
+	slot = (((memaddr) semAdd) >> 2) & (SEMPROFSIZE - 1);
+
+	for(i = 0; i < SEMPROFSIZE; i++) {
+		if(semProfTable[slot].sp_semAdd == semAdd)
+			return &(semProfTable[slot]);
+
+		if(semProfTable[slot].sp_semAdd == NULL) {
+			semProfTable[slot].sp_semAdd = semAdd;
+			return &(semProfTable[slot]);
+		}
+
+		slot = (slot + 1) & (SEMPROFSIZE - 1);
+	}
+
+	semProfDropped++;
+	return NULL;
+}
@@ -0,0 +1,92 @@
+/*
+ * adl.c supports the active delay list (ADL) of the support level.
+ *
+ * A U-proc calling DELAY gets a delay descriptor holding its ASID and
+ * the TOD it is due to wake at, then P's its private sema4. The delay
+ * daemon (see vmIOsupport.c) wakes each pseudo-clock tick, takes every
+ * expired descriptor off the ADL and V's its U-proc's private sema4.
+ *
+ * The ADL is kept as a singley linked list sorted on d_wakeTime, so
+ * the daemon only ever looks at its head. Descriptors come from a
+ * static table of MAXUPROC, since a U-proc sleeps at most once at a
+ * time; the free list is a singley linked stack.
+ *
+ * Callers are expected to hold the ADL mutex (adlSem).
+ *
+ * AUTHORS: Gavin Kyte & Ploy Sithisakulrat
+ * CONTRIBUTOR/ADVISOR: Michael Goldweber
+ */
+
+#include "../h/const.h"
+#include "../h/types.h"
+
+#include "../e/adl.e"
+
+HIDDEN delayd_t delayTable[MAXUPROC];
+HIDDEN delayd_PTR delaydFree_h; /* head of the free list */
+HIDDEN delayd_PTR delayd_h; /* head of the ADL, soonest first */
+
+/********************** External Methods *********************/
+/*
+ * initADL - Puts every delay descriptor on the free list
+ */
+void initADL() {
+	int i;
+
+	delaydFree_h = NULL;
+	delayd_h = NULL;
+	for(i = 0; i < MAXUPROC; i++) {
+		delayTable[i].d_next = delaydFree_h;
+		delaydFree_h = &(delayTable[i]);
+	}
+}
+
+/*
+ * insertDelay - Puts a U-proc on the ADL, after every sleeper due no
+ * later than it so equal wake times are served in arrival order
+ * PARAM: asid of the sleeping U-proc
+ *        wakeTime is the TOD it is due to wake at
+ * RETURN: FALSE if no free descriptor was left, TRUE otherwise
+ */
+Bool insertDelay(int asid, cpu_t wakeTime) {
+	delayd_PTR d, prev;
+
+	if(delaydFree_h == NULL)
+		return FALSE;
+
+	d = delaydFree_h;
+	delaydFree_h = d->d_next;
+	d->d_asid = asid;
+	d->d_wakeTime = wakeTime;
+
+	if(delayd_h == NULL || delayd_h->d_wakeTime > wakeTime) {
+		d->d_next = delayd_h;
+		delayd_h = d;
+		return TRUE;
+	}
+
+	prev = delayd_h;
+	while(prev->d_next != NULL && prev->d_next->d_wakeTime <= wakeTime)
+		prev = prev->d_next;
+
+	d->d_next = prev->d_next;
+	prev->d_next = d;
+	return TRUE;
+}
+
+/*
+ * removeExpired - Takes the soonest sleeper off the ADL if it is due
+ * PARAM: now is the current TOD
+ * RETURN: the sleeper's ASID, NOASID if none is due
+ */
+int removeExpired(cpu_t now) {
+	delayd_PTR d = delayd_h;
+
+	if(d == NULL || d->d_wakeTime > now)
+		return NOASID;
+
+	delayd_h = d->d_next;
+	d->d_next = delaydFree_h;
+	delaydFree_h = d;
+	return d->d_asid;
+}
@@ -0,0 +1,97 @@
+/*
+ * avsl.c supports the active virtual semaphore list (AVSL).
+ *
+ * Virtual semaphores live in the shared segment kUseg3 and are P'ed
+ * and V'ed by U-procs through PSEMVIRT and VSEMVIRT. A U-proc whose
+ * virtual P blocks is recorded here by ASID and semaphore address,
+ * then P's its private sema4; the matching V takes the oldest such
+ * record off and V's that U-proc's private sema4.
+ *
+ * The AVSL is a single FIFO, singley linked with head & tail pointers;
+ * with at most MAXUPROC blocked U-procs a search is cheap. Records come
+ * from a static table whose free list is a singley linked stack.
+ *
+ * Callers are expected to hold the AVSL mutex (avslSem).
+ *
+ * AUTHORS: Gavin Kyte & Ploy Sithisakulrat
+ * CONTRIBUTOR/ADVISOR: Michael Goldweber
+ */
+
+#include "../h/const.h"
+#include "../h/types.h"
+
+#include "../e/avsl.e"
+
+HIDDEN avsd_t avsdTable[MAXUPROC];
+HIDDEN avsd_PTR avsdFree_h; /* head of the free list */
+HIDDEN avsd_PTR avsd_h, avsdTail; /* the AVSL, oldest first */
+
+/********************** External Methods *********************/
+/*
+ * initAVSL - Puts every record on the free list
+ */
+void initAVSL() {
+	int i;
+
+	avsdFree_h = NULL;
+	avsd_h = avsdTail = NULL;
+	for(i = 0; i < MAXUPROC; i++) {
+		avsdTable[i].v_next = avsdFree_h;
+		avsdFree_h = &(avsdTable[i]);
+	}
+}
+
+/*
+ * insertVirtBlocked - Records a U-proc as blocked on a virtual sema4
+ * PARAM: semAdd is the kUseg3 semaphore
+ *        asid of the blocking U-proc
+ * RETURN: FALSE if no free record was left, TRUE otherwise
+ */
+Bool insertVirtBlocked(int* semAdd, int asid) {
+	avsd_PTR v;
+
+	if(avsdFree_h == NULL)
+		return FALSE;
+
+	v = avsdFree_h;
+	avsdFree_h = v->v_next;
+	v->v_semAdd = semAdd;
+	v->v_asid = asid;
+	v->v_next = NULL;
+
+	if(avsd_h == NULL)
+		avsd_h = v;
+	else
+		avsdTail->v_next = v;
+	avsdTail = v;
+	return TRUE;
+}
+
+/*
+ * removeVirtBlocked - Takes the U-proc blocked longest on a virtual
+ * sema4 off the AVSL
+ * PARAM: semAdd is the kUseg3 semaphore
+ * RETURN: its ASID, NOASID if none is blocked on semAdd
+ */
+int removeVirtBlocked(int* semAdd) {
+	avsd_PTR v = avsd_h, prev = NULL;
+
+	while(v != NULL && v->v_semAdd != semAdd) {
+		prev = v;
+		v = v->v_next;
+	}
+
+	if(v == NULL)
+		return NOASID;
+
+	if(prev == NULL)
+		avsd_h = v->v_next;
+	else
+		prev->v_next = v->v_next;
+	if(avsdTail == v)
+		avsdTail = prev;
+
+	v->v_next = avsdFree_h;
+	avsdFree_h = v;
+	return v->v_asid;
+}
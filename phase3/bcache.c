@@ -0,0 +1,237 @@
+/*
+ * bcache.c supports the support level's disk block cache.
+ *
+ * DISK_GET and DISK_PUT go through BCACHESIZE page sized buffers, each
+ * holding one sector of one disk. A hit costs a copy and no transfer;
+ * DISK_PUT only dirties a buffer, which is written back when it is
+ * reused, by the flusher daemon or by DISK_FLUSH (see vmIOsupport.c).
+ *
+ * Buffers are found through a hash index of BCACHEHASH singley linked
+ * chains keyed on disk & sector, and kept on a doubly linked LRU list,
+ * most recently used first; the buffer to reuse is its tail. Buffers
+ * holding nothing are on the list too, but on no chain. A buffer is
+ * busy while a transfer owns it with the cache mutex released; it is
+ * not reused, and the caller waits for it rather than touch it.
+ *
+ * Writes that bypass the cache are counted per disk, with a generation
+ * bumped as each starts and ends, so a miss that read the disk
+ * meanwhile knows not to keep what it read.
+ *
+ * Callers are expected to hold the cache mutex (cacheSem).
+ *
+ * AUTHORS: Gavin Kyte & Ploy Sithisakulrat
+ * CONTRIBUTOR/ADVISOR: Michael Goldweber
+ */
+
+#include "../h/const.h"
+#include "../h/types.h"
+
+#include "../e/bcache.e"
+
+HIDDEN bcache_t bufTable[BCACHESIZE];
+HIDDEN bcache_PTR hash_h[BCACHEHASH]; /* chain heads */
+HIDDEN bcache_PTR lru_h, lruTail; /* most & least recently used */
+HIDDEN int writeGens[DEVPERINT], writesOut[DEVPERINT]; /* by disk */
+
+HIDDEN int hashOf(int disk, int sector);
+HIDDEN void unhash(bcache_PTR b);
+HIDDEN void unlinkLRU(bcache_PTR b);
+
+/********************** External Methods *********************/
+/*
+ * initBCache - Gives every buffer its page and empties the index
+ * PARAM: base is the physical address of BCACHESIZE free pages
+ */
+void initBCache(memaddr base) {
+	int i;
+
+	for(i = 0; i < BCACHEHASH; i++)
+		hash_h[i] = NULL;
+	for(i = 0; i < DEVPERINT; i++)
+		writeGens[i] = writesOut[i] = 0;
+
+	lru_h = lruTail = NULL;
+	for(i = 0; i < BCACHESIZE; i++) {
+		bufTable[i].b_hnext = NULL;
+		bufTable[i].b_disk = NODISK;
+		bufTable[i].b_sector = 0;
+		bufTable[i].b_buf = base + i * PAGESIZE;
+		bufTable[i].b_dirty = FALSE;
+		bufTable[i].b_busy = FALSE;
+		bufTable[i].b_prev = NULL;
+		bufTable[i].b_next = lru_h;
+		if(lru_h == NULL)
+			lruTail = &(bufTable[i]);
+		else
+			lru_h->b_prev = &(bufTable[i]);
+		lru_h = &(bufTable[i]);
+	}
+}
+
+/*
+ * lookupBlock - Finds the buffer holding a sector
+ * PARAM: disk is the disk's device number, sector its linear number
+ * RETURN: the buffer, NULL on a miss
+ */
+bcache_PTR lookupBlock(int disk, int sector) {
+	bcache_PTR b = hash_h[hashOf(disk, sector)];
+
+	while(b != NULL && (b->b_disk != disk || b->b_sector != sector))
+		b = b->b_hnext;
+
+	return b;
+}
+
+/*
+ * lruBlock - The least recently used buffer that is not busy, the next
+ * to reuse. If it is dirty the caller writes it back before setBlock.
+ * RETURN: the buffer, NULL if every one is busy
+ */
+bcache_PTR lruBlock() {
+	bcache_PTR b = lruTail;
+
+	while(b != NULL && b->b_busy)
+		b = b->b_prev;
+
+	return b;
+}
+
+/*
+ * setBlock - Reindexes a buffer under another sector, clean
+ * PARAM: b is the buffer, its old contents written back or dropped
+ *        disk & sector name what it is to hold
+ */
+void setBlock(bcache_PTR b, int disk, int sector) {
+	unhash(b);
+
+	b->b_disk = disk;
+	b->b_sector = sector;
+	b->b_dirty = FALSE;
+	b->b_hnext = hash_h[hashOf(disk, sector)];
+	hash_h[hashOf(disk, sector)] = b;
+}
+
+/*
+ * dropBlock - Empties a buffer, whatever it held lost, and makes it
+ * the next to reuse
+ */
+void dropBlock(bcache_PTR b) {
+	unhash(b);
+	b->b_disk = NODISK;
+	b->b_dirty = FALSE;
+
+	if(b == lruTail)
+		return;
+
+	unlinkLRU(b);
+	b->b_next = NULL;
+	b->b_prev = lruTail;
+	lruTail->b_next = b;
+	lruTail = b;
+}
+
+/*
+ * touchBlock - Moves a buffer to the front of the LRU list
+ */
+void touchBlock(bcache_PTR b) {
+	if(b == lru_h)
+		return;
+
+	unlinkLRU(b);
+	b->b_prev = NULL;
+	b->b_next = lru_h;
+	lru_h->b_prev = b;
+	lru_h = b;
+}
+
+/*
+ * dirtyBlocks - Lists the dirty buffers of a disk
+ * PARAM: disk is the disk's device number
+ *        blocks has room for BCACHESIZE buffers
+ * RETURN: how many were listed
+ */
+int dirtyBlocks(int disk, bcache_PTR blocks[]) {
+	int i, count = 0;
+
+	for(i = 0; i < BCACHESIZE; i++) {
+		if(bufTable[i].b_disk == disk && bufTable[i].b_dirty)
+			blocks[count++] = &(bufTable[i]);
+	}
+
+	return count;
+}
+
+/*
+ * writeStarted - Notes a write to a disk that bypasses the cache
+ * PARAM: disk is the disk's device number
+ */
+void writeStarted(int disk) {
+	writeGens[disk]++;
+	writesOut[disk]++;
+}
+
+/*
+ * writeDone - Notes the end of a write writeStarted noted
+ * PARAM: disk is the disk's device number
+ */
+void writeDone(int disk) {
+	writesOut[disk]--;
+	writeGens[disk]++;
+}
+
+/*
+ * writeGen - A disk's write generation, to hand writesQuiet later
+ * PARAM: disk is the disk's device number
+ */
+int writeGen(int disk) {
+	return writeGens[disk];
+}
+
+/*
+ * writesQuiet - Whether no write bypassing the cache has overlapped a
+ * disk transfer, so what it read can be cached
+ * PARAM: disk is the disk's device number
+ *        gen is writeGen's answer from before the transfer
+ * RETURN: TRUE if no such write started, ended or is under way since
+ */
+Bool writesQuiet(int disk, int gen) {
+	return (writeGens[disk] == gen && writesOut[disk] == 0);
+}
+
+/********************** Helper Methods **********************/
+/*
+ * hashOf - Hash bucket of a sector
+ */
+HIDDEN int hashOf(int disk, int sector) {
+	return (sector * DEVPERINT + disk) & (BCACHEHASH - 1);
+}
+
+/*
+ * unhash - Takes a buffer off its hash chain, if it is on one
+ */
+HIDDEN void unhash(bcache_PTR b) {
+	bcache_PTR* link;
+
+	if(b->b_disk == NODISK)
+		return;
+
+	link = &(hash_h[hashOf(b->b_disk, b->b_sector)]);
+	while(*link != b)
+		link = &((*link)->b_hnext);
+	*link = b->b_hnext;
+}
+
+/*
+ * unlinkLRU - Takes a buffer off the LRU list
+ */
+HIDDEN void unlinkLRU(bcache_PTR b) {
+	if(b->b_prev == NULL)
+		lru_h = b->b_next;
+	else
+		b->b_prev->b_next = b->b_next;
+
+	if(b->b_next == NULL)
+		lruTail = b->b_prev;
+	else
+		b->b_next->b_prev = b->b_prev;
+}
@@ -0,0 +1,102 @@
+/*	Test the disk scheduler under a mixed load. Mount it on several
+ *	tapes at once: each U-proc interleaves DISK_PUTs and DISK_GETs
+ *	that alternate between the two ends of disk1, so in arrival order
+ *	nearly every transfer would seek across the disk.
+ *	A GET reads back a sector PUT LAG transfers earlier, far enough
+ *	back to miss the block cache, and checks the sector it names.
+ *
+ *	Reports the disk's requests, seeks and mean wait over its run, from
+ *	DISK_STATS; with the C-SCAN queues seeks stay well below requests.
+ *	The other U-procs' transfers are counted too, so the last one to
+ *	finish reports the whole load.
+ */
+#include "../../h/const.h"
+#include "../../h/types.h"
+
+#include "/usr/local/include/umps2/umps/libumps.e"
+
+#include "h/tconst.h"
+#include "print.e"
+
+#define MIXDISK		1
+#define OPS			64		/* PUT & GET pairs */
+#define LAG			16
+#define SPREAD		128		/* sectors used at each end of the disk */
+#define FAREND		384		/* of a default 512 sector disk */
+#define STRIDE		5
+#define DIGITS		12
+
+/* sector of the i-th PUT; seed staggers the U-procs */
+int mixSector(int i, int seed) {
+	return ((i % 2) ? FAREND : 0) + ((i * STRIDE + seed) % SPREAD);
+}
+
+/* print a non-negative number in decimal */
+void printNum(int n) {
+	char buf[DIGITS];
+	int i = DIGITS - 1;
+
+	buf[i] = '\0';
+	do {
+		buf[--i] = '0' + (n % 10);
+		n = n / 10;
+	} while (n > 0 && i > 0);
+
+	print(WRITETERMINAL, &buf[i]);
+}
+
+void main() {
+	int *out, *in;
+	int i, seed, sector, bad = 0;
+	diskstat_t before, after;
+	cpu_t start, stop;
+
+	out = (int *)(SEG2 + (20 * PAGESIZE));
+	in = (int *)(SEG2 + (21 * PAGESIZE));
+
+	print(WRITETERMINAL, "diskMixTest starts\n");
+	start = SYSCALL(GET_TOD, 0, 0, 0);
+	seed = (start / 1000) % SPREAD;
+	SYSCALL(DISK_STATS, (int)&before, MIXDISK, 0);
+
+	for (i = 0; i < OPS; i++) {
+		sector = mixSector(i, seed);
+		out[0] = sector;
+		out[1] = i;
+		if (SYSCALL(DISK_PUT, (int)out, MIXDISK, sector) != READY)
+			bad++;
+
+		if (i >= LAG) {
+			sector = mixSector(i - LAG, seed);
+			if (SYSCALL(DISK_GET, (int)in, MIXDISK, sector) != READY ||
+					in[0] != sector)
+				bad++;
+		}
+	}
+	SYSCALL(DISK_FLUSH, MIXDISK, 0, 0);
+
+	stop = SYSCALL(GET_TOD, 0, 0, 0);
+	SYSCALL(DISK_STATS, (int)&after, MIXDISK, 0);
+
+	if (bad > 0)
+		print(WRITETERMINAL, "diskMixTest error: bad transfers or readback\n");
+	else
+		print(WRITETERMINAL, "diskMixTest ok: transfers and readback\n");
+
+	print(WRITETERMINAL, "diskMixTest: requests ");
+	printNum(after.ds_requests - before.ds_requests);
+	print(WRITETERMINAL, " seeks ");
+	printNum(after.ds_seeks - before.ds_seeks);
+	print(WRITETERMINAL, " mean wait ");
+	if (after.ds_requests > before.ds_requests)
+		printNum((after.ds_sumLatency - before.ds_sumLatency) /
+			(after.ds_requests - before.ds_requests));
+	else
+		printNum(0);
+	print(WRITETERMINAL, " us, run ");
+	printNum((stop - start) / 1000);
+	print(WRITETERMINAL, " ms\n");
+
+	print(WRITETERMINAL, "diskMixTest completed\n");
+	SYSCALL(TERMINATE, 0, 0, 0);
+}
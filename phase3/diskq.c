@@ -0,0 +1,120 @@
+/*
+ * diskq.c supports the support level's per-disk request queues.
+ *
+ * Every transfer to a disk, the pager's and the U-procs' alike, is
+ * queued here and served by that disk's daemon (see vmIOsupport.c)
+ * instead of each requester taking turns on a device mutex.
+ *
+ * A queue is a singley linked list sorted on r_sector, oldest first
+ * among equal sectors. Sectors are numbered cylinder major, so sector
+ * order is cylinder order and the daemon serves a queue C-SCAN style:
+ * the next request is the first at or beyond the last sector served,
+ * wrapping to the lowest when none is. Requests for neighbouring
+ * sectors are so served back to back on one cylinder; uMPS2 moves one
+ * sector per command, so they are chained rather than fused.
+ *
+ * Reads of one sector queued together are merged: the daemon takes
+ * them off with removeSameRead and serves them from one transfer.
+ *
+ * Callers are expected to hold the disk's mutex (devMutex).
+ *
+ * AUTHORS: Gavin Kyte & Ploy Sithisakulrat
+ * CONTRIBUTOR/ADVISOR: Michael Goldweber
+ */
+
+#include "../h/const.h"
+#include "../h/types.h"
+
+#include "../e/diskq.e"
+
+HIDDEN diskreq_PTR diskQ_h[DEVPERINT]; /* heads, lowest sector first */
+
+/********************** External Methods *********************/
+/*
+ * initDiskQ - Empties every disk's queue
+ */
+void initDiskQ() {
+	int i;
+
+	for(i = 0; i < DEVPERINT; i++)
+		diskQ_h[i] = NULL;
+}
+
+/*
+ * insertDiskReq - Queues a request behind those for lower or the same
+ * sector
+ * PARAM: disk is the disk's device number
+ *        req is the filled in request
+ */
+void insertDiskReq(int disk, diskreq_PTR req) {
+	diskreq_PTR prev = NULL, cur = diskQ_h[disk];
+
+	while(cur != NULL && cur->r_sector <= req->r_sector) {
+		prev = cur;
+		cur = cur->r_next;
+	}
+
+	req->r_next = cur;
+	if(prev == NULL)
+		diskQ_h[disk] = req;
+	else
+		prev->r_next = req;
+}
+
+/*
+ * removeNextReq - Takes the next request off a queue in C-SCAN order
+ * PARAM: disk is the disk's device number
+ *        fromSector is the sector the disk last served
+ * RETURN: the request, NULL if the queue is empty
+ */
+diskreq_PTR removeNextReq(int disk, int fromSector) {
+	diskreq_PTR prev = NULL, cur = diskQ_h[disk];
+
+	while(cur != NULL && cur->r_sector < fromSector) {
+		prev = cur;
+		cur = cur->r_next;
+	}
+
+	if(cur == NULL) { /* end of the sweep, back to the lowest sector */
+		prev = NULL;
+		cur = diskQ_h[disk];
+		if(cur == NULL)
+			return NULL;
+	}
+
+	if(prev == NULL)
+		diskQ_h[disk] = cur->r_next;
+	else
+		prev->r_next = cur->r_next;
+
+	cur->r_next = NULL;
+	return cur;
+}
+
+/*
+ * removeSameRead - Takes off a read of the sector a read being served
+ * transfers, unless a write to it was queued in between
+ * PARAM: disk is the disk's device number
+ *        served is the read being served, already off the queue
+ * RETURN: the request, NULL if there is none to merge
+ */
+diskreq_PTR removeSameRead(int disk, diskreq_PTR served) {
+	diskreq_PTR prev = NULL, cur = diskQ_h[disk];
+
+	while(cur != NULL && cur->r_sector < served->r_sector) {
+		prev = cur;
+		cur = cur->r_next;
+	}
+
+	if(cur == NULL || cur->r_sector != served->r_sector ||
+		cur->r_cmd != DISKREAD || served->r_cmd != DISKREAD)
+		return NULL;
+
+	if(prev == NULL)
+		diskQ_h[disk] = cur->r_next;
+	else
+		prev->r_next = cur->r_next;
+
+	cur->r_next = NULL;
+	return cur;
+}
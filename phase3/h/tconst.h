@@ -14,6 +14,12 @@
 #define WRITEPRINTER	16
 #define GET_TOD			17
 #define TERMINATE		18
+#define DISK_FLUSH		19
+#define DISK_GETV		20
+#define DISK_PUTV		21
+#define DRAINTERMINAL	22
+#define WAITPRINTJOB	23
+#define DISK_STATS		24
 
 #define SEG0		0x00000000
 #define SEG1		0x40000000
@@ -0,0 +1,359 @@
+/************************ INITPROC.C **************************
+ *
+ * Start the Kaya OS support level (the nucleus's first process)
+ *    Map ksegOS & kUseg3, fill the segment table
+ *    Carve the support level's pages out of the top of RAM
+ *    Start the delay & cache flusher daemons, a daemon per installed
+ *    disk, terminal & printer and a U-proc per installed tape
+ *    Wait for every U-proc to end, flush the block cache, report the
+ *    pager's counters
+ *
+ * Physical memory below the nucleus's two stack pages, from the top:
+ *    delay daemon stack, cache flusher stack
+ *    a stack per disk daemon, then per terminal transmit & receive daemon,
+ *    then per printer daemon
+ *    per U-proc: TLB handler stack, SYS & PGM handler stack
+ *    a DMA buffer per U-proc, for its tape & DISK_PUT/DISK_GET
+ *    the block cache's buffers
+ *    the swap pool
+ * All of it must fit under ROMPAGESTART + KSEGOSPTESIZE pages, the
+ * part of ksegOS the handlers can address with VM on.
+ *
+ * A U-proc starts in uProcInit, in kernel mode, which copies its tape
+ * to the backing store, SPECTRAPVECs the support handlers and drops
+ * to user mode at the a.out entry point.
+ *
+ * AUTHORS: Gavin Kyte & Ploy Sithisakulrat
+ * ADVISOR/CONTRIBUTER: Michael Goldweber
+ *************************************************************/
+
+#include "../h/const.h"
+#include "../h/types.h"
+
+#include "../e/initProc.e"
+#include "../e/vmIOsupport.e"
+#include "../e/adl.e"
+#include "../e/avsl.e"
+#include "../e/diskq.e"
+#include "../e/bcache.e"
+#include "/usr/local/include/umps2/umps/libumps.e"
+
+uproc_t uProcs[MAXUPROC];
+pteOS_t ksegOSPte;
+pteUser_t kUseg3Pte; /* shared by every U-proc */
+swap_t swapPool[SWAPPOOLSIZE];
+memaddr swapPoolBase, dmaBufBase;
+swapext_t swapExtents[MAXUPROC + 1]; /* by owner, see initSwapSpace */
+int diskCyl[DEVPERINT]; /* cylinder each disk's head is on, -1 if unknown */
+diskstat_t diskStats[DEVPERINT];
+cachestat_t cacheStats;
+termring_t txRings[DEVPERINT], rxRings[DEVPERINT]; /* by terminal */
+spool_t spools[DEVPERINT]; /* by printer */
+HIDDEN memaddr stackTop, uProcStacks, cacheBase;
+
+int swapSem; /* mutex on the swap pool & page tables */
+int masterSem; /* V'ed by each U-proc as it ends */
+int adlSem, avslSem; /* mutexes on the ADL & AVSL */
+int devMutex[DEVSEMNUM]; /* support level mutex per device sema4 */
+int diskWork[DEVPERINT]; /* requests queued for each disk's daemon */
+int cacheSem; /* mutex on the block cache */
+int cacheWait, cacheWaiters; /* who waits on busy cache buffers */
+int pinSem, pinMutex; /* frames left to pin; mutex on reserving them */
+
+HIDDEN void initSegments();
+HIDDEN void initSwapSpace();
+HIDDEN void uProcInit();
+HIDDEN void loadTape(int asid);
+HIDDEN void initRing(termring_t* ring);
+HIDDEN void startDaemon(state_t* daemon, memaddr code, int page, int dev);
+
+/*
+ * Set up virtual memory & the support level's data, start the
+ * U-procs and wait for them.
+ */
+void test() {
+	int i, asid, disk, started;
+	memaddr top;
+	devregarea_t* bus = (devregarea_t*) RAMBASEADDR;
+	uproc_PTR up;
+	state_t daemon, start;
+
+	/* Stay under what ksegOS maps and the nucleus's stack pages */
+	top = MIN(bus->rambase + bus->ramsize,
+		ROMPAGESTART + KSEGOSPTESIZE * PAGESIZE);
+	stackTop = top - 2 * PAGESIZE;
+	uProcStacks = stackTop - (2 + 4 * DEVPERINT) * PAGESIZE;
+	dmaBufBase = uProcStacks - 3 * MAXUPROC * PAGESIZE; /* 2 stacks + 1 */
+	cacheBase = dmaBufBase - BCACHESIZE * PAGESIZE;
+	swapPoolBase = cacheBase - SWAPPOOLSIZE * PAGESIZE;
+
+	initSegments();
+	initSwapSpace();
+	initADL();
+	initAVSL();
+	initDiskQ();
+	initBCache(cacheBase);
+
+	for(i = 0; i < SWAPPOOLSIZE; i++) {
+		swapPool[i].sw_asid = NOASID;
+		swapPool[i].sw_pinned = 0;
+	}
+
+	for(i = 0; i < DEVSEMNUM; i++)
+		devMutex[i] = 1;
+	for(i = 0; i < DEVPERINT; i++) {
+		diskCyl[i] = -1;
+		diskWork[i] = 0;
+		diskStats[i].ds_requests = diskStats[i].ds_merged = 0;
+		diskStats[i].ds_seeks = 0;
+		diskStats[i].ds_sumLatency = diskStats[i].ds_maxLatency = 0;
+		diskStats[i].ds_busy = 0;
+
+		initRing(&(txRings[i]));
+		initRing(&(rxRings[i]));
+
+		spools[i].sp_head = spools[i].sp_count = 0;
+		spools[i].sp_jobHead = spools[i].sp_jobs = 0;
+		spools[i].sp_lastJob = spools[i].sp_doneJob = 0;
+		spools[i].sp_status = READY;
+		spools[i].sp_idle = FALSE;
+		spools[i].sp_work = spools[i].sp_space = spools[i].sp_event = 0;
+		spools[i].sp_writers = spools[i].sp_waiters = 0;
+	}
+	cacheStats.cs_hits = cacheStats.cs_misses = 0;
+	cacheStats.cs_puts = cacheStats.cs_writeBacks = 0;
+	swapSem = adlSem = avslSem = cacheSem = pinMutex = 1;
+	pinSem = MAXPINNED;
+	masterSem = cacheWait = cacheWaiters = 0;
+
+	/* The delay & flusher daemons run in kernel mode with VM off */
+	STST(&daemon);
+	daemon.s_asid = 0;
+	daemon.s_status = LOCALTIMEON | INTMASKOFF | INTpON;
+	startDaemon(&daemon, (memaddr) delayDaemon, 0, 0);
+	startDaemon(&daemon, (memaddr) cacheFlusher, 1, 0);
+
+	/* As are the device daemons, which get their device's number in a0 */
+	for(disk = 0; disk < DEVPERINT; disk++) {
+		if((bus->inst_dev[DISKINT - LINENUMOFFSET] & (1 << disk)) != 0)
+			startDaemon(&daemon, (memaddr) diskDaemon, 2 + disk, disk);
+	}
+	for(i = 0; i < DEVPERINT; i++) {
+		if((bus->inst_dev[TERMINT - LINENUMOFFSET] & (1 << i)) == 0)
+			continue;
+		startDaemon(&daemon, (memaddr) termTxDaemon,
+			2 + DEVPERINT + 2 * i, i);
+		startDaemon(&daemon, (memaddr) termRxDaemon,
+			3 + DEVPERINT + 2 * i, i);
+	}
+	for(i = 0; i < DEVPERINT; i++) {
+		if((bus->inst_dev[PRNTINT - LINENUMOFFSET] & (1 << i)) != 0)
+			startDaemon(&daemon, (memaddr) printDaemon,
+				2 + 3 * DEVPERINT + i, i);
+	}
+
+	started = 0;
+	for(asid = 1; asid <= MAXUPROC; asid++) {
+		up = &(uProcs[asid - 1]);
+		up->u_sem = 0;
+		up->u_stats.vm_faults = up->u_stats.vm_softFaults = 0;
+		up->u_stats.vm_pageIns = up->u_stats.vm_pageOuts = 0;
+		up->u_stats.vm_cleanDrops = 0;
+		up->u_stats.vm_raPages = up->u_stats.vm_raHits = 0;
+		up->u_stats.vm_inTime = 0;
+		up->u_lastFault = -1; /* so a first fault on page 0 is sequential */
+		up->u_raWindow = 0;
+
+		if((bus->inst_dev[TAPEINT - LINENUMOFFSET] & (1 << (asid - 1))) == 0)
+			continue;
+
+		up->u_pte.pt_header = (PTEMAGICNO << 24) | KUSEGPTESIZE;
+		for(i = 0; i < KUSEGPTESIZE; i++) {
+			up->u_pte.pt_entries[i].pte_entryHI =
+				(KUSEG2ADDR + i * PAGESIZE) | (asid << ASIDSHIFT);
+			up->u_pte.pt_entries[i].pte_entryLO = 0;
+		}
+		up->u_pte.pt_entries[STACKPAGE].pte_entryHI =
+			(STACKVPN << VPNSHIFT) | (asid << ASIDSHIFT);
+		((segTbl_t*) SEGTBLADDR)[asid].st_kUseg2 = &(up->u_pte);
+
+		/* Handlers: kernel mode, VM & interrupts on, own stacks */
+		for(i = 0; i < TRAPTYPES; i++) {
+			STST(&(up->u_newTrap[i]));
+			up->u_newTrap[i].s_asid = asid << ASIDSHIFT;
+			up->u_newTrap[i].s_status =
+				VMpON | LOCALTIMEON | INTMASKOFF | INTpON;
+		}
+		up->u_newTrap[TLBTRAP].s_sp = uProcStacks - 2 * (asid - 1) * PAGESIZE;
+		up->u_newTrap[PROGTRAP].s_sp = up->u_newTrap[SYSTRAP].s_sp =
+			uProcStacks - (1 + 2 * (asid - 1)) * PAGESIZE;
+		up->u_newTrap[TLBTRAP].s_pc = up->u_newTrap[TLBTRAP].s_t9 =
+			(memaddr) vmTlbHandler;
+		up->u_newTrap[PROGTRAP].s_pc = up->u_newTrap[PROGTRAP].s_t9 =
+			(memaddr) vmPgmHandler;
+		up->u_newTrap[SYSTRAP].s_pc = up->u_newTrap[SYSTRAP].s_t9 =
+			(memaddr) vmSysHandler;
+
+		/* uProcInit starts like its SYS handler would */
+		STST(&start);
+		start.s_asid = asid << ASIDSHIFT;
+		start.s_status = up->u_newTrap[SYSTRAP].s_status;
+		start.s_sp = up->u_newTrap[SYSTRAP].s_sp;
+		start.s_pc = start.s_t9 = (memaddr) uProcInit;
+
+		if(SYSCALL(CREATEPROCESS, (int) &start, 0, 0) != NOCHILD)
+			started++;
+	}
+
+	for(i = 0; i < started; i++)
+		SYSCALL(PASSEREN, (int) &masterSem, 0, 0);
+
+	for(disk = BACKINGDISK + 1; disk < DEVPERINT; disk++)
+		flushCache(disk);
+	reportVM();
+	SYSCALL(TERMINATEPROCESS, 0, 0, 0); /* takes the daemons along */
+}
+
+/*
+ * initSegments - Builds the ksegOS & kUseg3 page tables and points
+ * every ASID's segment table row at them. ksegOS is identity mapped
+ * and global; kUseg3 is global and starts with no page loaded or dirty.
+ */
+HIDDEN void initSegments() {
+	int i;
+	segTbl_t* segTbl = (segTbl_t*) SEGTBLADDR;
+
+	ksegOSPte.pt_header = (PTEMAGICNO << 24) | KSEGOSPTESIZE;
+	for(i = 0; i < KSEGOSPTESIZE; i++) {
+		ksegOSPte.pt_entries[i].pte_entryHI = ROMPAGESTART + i * PAGESIZE;
+		ksegOSPte.pt_entries[i].pte_entryLO = (ROMPAGESTART + i * PAGESIZE) |
+			PTEDIRTY | PTEVALID | PTEGLOBAL;
+	}
+
+	kUseg3Pte.pt_header = (PTEMAGICNO << 24) | KUSEGPTESIZE;
+	for(i = 0; i < KUSEGPTESIZE; i++) {
+		kUseg3Pte.pt_entries[i].pte_entryHI = KUSEG3ADDR + i * PAGESIZE;
+		kUseg3Pte.pt_entries[i].pte_entryLO = PTEGLOBAL;
+	}
+
+	for(i = 0; i < MAXASID; i++) {
+		segTbl[i].st_ksegOS = &ksegOSPte;
+		segTbl[i].st_kUseg2 = NULL; /* until a U-proc gets the ASID */
+		segTbl[i].st_kUseg3 = &kUseg3Pte;
+	}
+}
+
+/*
+ * initSwapSpace - Lays out the backing store: one extent per owner, the
+ * shared kUseg3 first, then each U-proc by ASID. A process's pages are
+ * consecutive sectors, and an extent that fits in a cylinder is never
+ * split across two, so paging a process in or out needs at most one
+ * seek. With SEEKAWARESWAP off the owners' pages are interleaved
+ * instead, for comparison.
+ */
+HIDDEN void initSwapSpace() {
+	device_t* disk = devReg(DISKINT, BACKINGDISK);
+	int perCyl, next = 0, owner;
+
+	perCyl = ((disk->d_data1 >> DISKHEADSHIFT) & DISKFIELDMASK) *
+		(disk->d_data1 & DISKFIELDMASK);
+
+	for(owner = SHAREDASID; owner <= MAXUPROC; owner++) {
+		swapExtents[owner].se_pages = KUSEGPTESIZE;
+		if(!SEEKAWARESWAP) {
+			swapExtents[owner].se_start = owner;
+			continue;
+		}
+
+		/* Start on a fresh cylinder rather than straddle two */
+		if(KUSEGPTESIZE <= perCyl && next % perCyl + KUSEGPTESIZE > perCyl)
+			next += perCyl - next % perCyl;
+		swapExtents[owner].se_start = next;
+		next += KUSEGPTESIZE;
+	}
+}
+
+/*
+ * uProcInit - First code of every U-proc, in kernel mode with VM on.
+ * Loads its program, hands its exceptions to the support level and
+ * starts it in user mode.
+ */
+HIDDEN void uProcInit() {
+	int asid = (getENTRYHI() & ASIDMASK) >> ASIDSHIFT, i;
+	uproc_PTR up = &(uProcs[asid - 1]);
+	state_t start;
+
+	loadTape(asid);
+
+	for(i = 0; i < TRAPTYPES; i++)
+		SYSCALL(SPECTRAPVEC, i, (int) &(up->u_oldTrap[i]),
+			(int) &(up->u_newTrap[i]));
+
+	/* User mode, VM, interrupts & local timer on */
+	STST(&start);
+	start.s_asid = asid << ASIDSHIFT;
+	start.s_status =
+		VMpON | USERMODEON | LOCALTIMEON | INTMASKOFF | INTpON;
+	start.s_sp = UPROCSTACK;
+	start.s_pc = start.s_t9 = UPROCSTART;
+	LDST(&start);
+}
+
+/*
+ * loadTape - Copies a U-proc's tape, a block per page, to its pages
+ * on the backing store, marking those pages PTEONDISK
+ * PARAM: asid of the U-proc, which reads tape asid - 1
+ */
+HIDDEN void loadTape(int asid) {
+	int tapeNo = asid - 1, page = 0, status;
+	int* tapeMutex = &(devMutex[DEVSEMINDEX(TAPEINT, tapeNo, FALSE)]);
+	device_t* tape = devReg(TAPEINT, tapeNo);
+	memaddr buf = dmaBufBase + tapeNo * PAGESIZE;
+	pte_PTR pte;
+
+	SYSCALL(PASSEREN, (int) tapeMutex, 0, 0);
+	do {
+		tape->d_data0 = buf;
+		status = doIO(&(tape->d_command), TAPEREAD, TAPEINT, tapeNo, FALSE);
+		if((status & DEVSTATUSMASK) != READY) {
+			SYSCALL(VERHOGEN, (int) tapeMutex, 0, 0);
+			killUProc(asid);
+		}
+
+		status = diskRequest(BACKINGDISK, backingSector(asid, page), buf,
+			DISKWRITE);
+		if(status != READY)
+			PANIC();
+
+		pte = &(uProcs[asid - 1].u_pte.pt_entries[page]);
+		pte->pte_entryLO |= PTEONDISK;
+		page++;
+	} while(tape->d_data1 == TAPEEOB && page < KUSEG2PAGES);
+	SYSCALL(VERHOGEN, (int) tapeMutex, 0, 0);
+}
+
+/*
+ * initRing - Empties a terminal ring
+ */
+HIDDEN void initRing(termring_t* ring) {
+	ring->tr_head = ring->tr_count = ring->tr_lines = 0;
+	ring->tr_status = READY;
+	ring->tr_idle = FALSE;
+	ring->tr_work = ring->tr_space = ring->tr_event = 0;
+	ring->tr_writers = ring->tr_waiters = 0;
+}
+
+/*
+ * startDaemon - Creates a daemon from a template state. Without it its
+ * device's users would wait forever, so running out of pcbs PANICs.
+ * PARAM: daemon is the template, kernel mode with VM off
+ *        code is its entry point, page its stack's page below stackTop
+ *        dev is handed to it in a0
+ */
+HIDDEN void startDaemon(state_t* daemon, memaddr code, int page, int dev) {
+	daemon->s_sp = stackTop - page * PAGESIZE;
+	daemon->s_pc = daemon->s_t9 = code;
+	daemon->s_a0 = dev;
+	if(SYSCALL(CREATEPROCESS, (int) daemon, 0, 0) == NOCHILD)
+		PANIC();
+}
@@ -0,0 +1,1933 @@
+/*********************** VMIOSUPPORT.C ************************
+ *
+ * Support level exception handlers for Kaya OS U-procs
+ *
+ * Each U-proc SPECTRAPVECs its three exception types here, so the
+ * nucleus passes them up to:
+ *    vmTlbHandler - the pager
+ *    vmPgmHandler - kills the U-proc
+ *    vmSysHandler - SYS9-SYS24
+ * They run as the U-proc itself, in kernel mode with VM on, on stack
+ * pages of their own (see initProc).
+ *
+ * The pager demand-loads kUseg2 and kUseg3 pages into a pool of
+ * SWAPPOOLSIZE frames backed by disk0. Victims are picked by a
+ * second-chance clock: the hand skips a frame referenced since it last
+ * passed, clearing its sw_ref and the V bit of its entry on the way.
+ * The page stays in its frame (PTERESIDENT), so the next touch costs
+ * a soft fault that only sets sw_ref and V again; untouched frames are
+ * the ones reused. uMPS2 keeps no reference bits, this is how we get
+ * them.
+ *
+ * Pages are mapped without the D (write enable) bit, so the first store
+ * to one raises a TLB-Modification; the pager then sets D, which from
+ * there on marks the page dirty. A clean victim still matches its copy
+ * on the backing store, or was never written at all, so it is dropped
+ * without a DISK_PUT.
+ *
+ * A fault on the kUseg2 page after the U-proc's last one reads up to
+ * u_raWindow following pages into free frames, queued all at once.
+ * They are left resident but invalid, so their first touch is a soft
+ * fault telling the pager the readahead paid off. The window doubles
+ * (to RAMAXWINDOW) on each sequential fault and halves on any other
+ * fault or when a page read ahead is evicted untouched.
+ *
+ * Each installed disk has a daemon of its own, the only process that
+ * commands it. Requesters, the pager included, queue a diskreq_t (see
+ * diskq.c) and P its r_done; the daemon serves the queue in C-SCAN
+ * order, merging reads of one sector, and V's each r_done as its
+ * transfer completes.
+ *
+ * DISK_GET and DISK_PUT go through the block cache (see bcache.c).
+ * What they do transfer goes straight to or from the U-proc's frame
+ * when its page is page aligned: the frame is pinned, so the clock
+ * passes it over, and its physical address given to the disk.
+ * DISK_GETV and DISK_PUTV queue a whole vector of such transfers before
+ * waiting on any, so the U-proc blocks once for all of them.
+ * DISK_PUT leaves its page dirty in a buffer; the flusher daemon writes
+ * dirty buffers back every FLUSHTICKS pseudo-clock ticks, and DISK_FLUSH
+ * does so for one disk on demand. DISK_STATS hands out a disk's
+ * scheduler counters.
+ *
+ * WRITETERMINAL only queues its string on the terminal's transmit ring
+ * (see termring_t); the terminal's daemon transmits it a character per
+ * WAITIO, so the writer runs on meanwhile. Likewise the terminal's
+ * receive daemon keeps its receiver armed and collects input on a ring
+ * of its own, waking READTERMINAL only once a line is complete.
+ * WRITEPRINTER spools its string as a numbered job (see spool_t) for
+ * the printer's daemon, and WAITPRINTJOB waits for a job to be printed.
+ *
+ * AUTHORS: Gavin Kyte & Ploy Sithisakulrat
+ * ADVISOR/CONTRIBUTER: Michael Goldweber
+ *************************************************************/
+
+#include "../h/const.h"
+#include "../h/types.h"
+
+#include "../e/initProc.e"
+#include "../e/vmIOsupport.e"
+#include "../e/adl.e"
+#include "../e/avsl.e"
+#include "../e/diskq.e"
+#include "../e/bcache.e"
+#include "/usr/local/include/umps2/umps/libumps.e"
+
+HIDDEN int clockHand; /* next swap pool frame the clock looks at */
+
+HIDDEN int curAsid();
+HIDDEN pte_PTR findPte(int asid, unsigned int vpn, int* owner, int* page);
+HIDDEN void setPte(pte_PTR pte, unsigned int entryLO);
+HIDDEN int pickVictim();
+HIDDEN int freeFrame();
+HIDDEN int diskIO(int disk, int sector, memaddr buf, int cmd);
+HIDDEN void diskSubmit(int disk, diskreq_PTR req);
+HIDDEN int diskWait(diskreq_PTR req);
+HIDDEN Bool devInstalled(int lineNum, int deviceNum);
+HIDDEN int diskSectors(int disk);
+HIDDEN bcache_PTR findBlock(int disk, int sector);
+HIDDEN void releaseBlock(bcache_PTR b);
+HIDDEN bcache_PTR claimBlock(int disk, int sector);
+HIDDEN int diskUser(int asid, memaddr buf, int disk, int sector, int cmd);
+HIDDEN memaddr pinUser(int asid, memaddr buf, Bool willWrite);
+HIDDEN void unpinUser(memaddr frame);
+HIDDEN void reservePins(int count);
+HIDDEN int diskVector(int asid, diskvec_t* vec, int count, int disk,
+	int cmd);
+HIDDEN void readAhead(int asid, int page);
+HIDDEN void evict(int frame, vmstat_PTR stats);
+HIDDEN void pageIn(int frame, int owner, int page, pte_PTR pte,
+	vmstat_PTR stats);
+HIDDEN memaddr frameAddr(int frame);
+HIDDEN int whichRegion(memaddr addr);
+HIDDEN Bool validUser(memaddr addr, int len);
+HIDDEN void copyPage(memaddr from, memaddr to);
+HIDDEN int sys9_readTerminal(int asid, char* buf);
+HIDDEN int sys10_writeTerminal(int asid, char* str, int len);
+HIDDEN void sys11_vSemVirt(int asid, int* semAdd);
+HIDDEN void sys12_pSemVirt(int asid, int* semAdd);
+HIDDEN void sys13_delay(int asid, int secs);
+HIDDEN int sys14_diskPut(int asid, memaddr buf, int disk, int sector);
+HIDDEN int sys15_diskGet(int asid, memaddr buf, int disk, int sector);
+HIDDEN int sys16_writePrinter(int asid, char* str, int len);
+HIDDEN cpu_t sys17_getTOD();
+HIDDEN int sys19_diskFlush(int asid, int disk);
+HIDDEN int sys20_diskGetV(int asid, diskvec_t* vec, int count, int disk);
+HIDDEN int sys21_diskPutV(int asid, diskvec_t* vec, int count, int disk);
+HIDDEN int sys22_drainTerminal(int asid);
+HIDDEN int sys23_waitPrintJob(int asid, int job);
+HIDDEN int sys24_diskStats(int asid, diskstat_t* stats, int disk);
+HIDDEN int spoolWait(int prnt, int job);
+HIDDEN int termWrite(int term, char* str, int len);
+HIDDEN int termDrain(int term);
+HIDDEN int appendField(char* line, int len, char* label, int n);
+
+/********************* External Methods *********************/
+/*
+ * vmTlbHandler - The pager, reached on a TLB-Invalid or a
+ * TLB-Modification for a page of kUseg2 or kUseg3. Any other TLB
+ * exception kills the U-proc.
+ *
+ * On TLB-Invalid, loads the missing page into a frame of the swap pool,
+ * evicting the clock's victim first; on TLB-Modification, marks the
+ * page dirty. Then restarts the U-proc.
+ */
+void vmTlbHandler() {
+	int asid, cause, owner, page, frame;
+	uproc_PTR up;
+	state_PTR old;
+	pte_PTR pte;
+
+	asid = curAsid();
+	up = &(uProcs[asid - 1]);
+	old = &(up->u_oldTrap[TLBTRAP]);
+
+	cause = EXCCODE(old->s_cause);
+	if(cause != TLBMODCODE && cause != TLBLCODE && cause != TLBSCODE)
+		killUProc(asid);
+
+	/* EntryHi holds the VPN of the failed translation */
+	pte = findPte(asid, old->s_asid >> VPNSHIFT, &owner, &page);
+	if(pte == NULL)
+		killUProc(asid);
+
+	SYSCALL(PASSEREN, (int) &swapSem, 0, 0);
+
+	if(cause == TLBMODCODE) {
+		/* First store since it was loaded; unless evicted meanwhile */
+		if(pte->pte_entryLO & PTEVALID)
+			setPte(pte, pte->pte_entryLO | PTEDIRTY);
+	} else if((pte->pte_entryLO & PTEVALID) == 0) {
+		/* (a valid one was shared & loaded by another U-proc meanwhile) */
+		if(pte->pte_entryLO & PTERESIDENT) {
+			/* Read ahead, or the clock took its second chance */
+			frame = ((pte->pte_entryLO & PFNMASK) - swapPoolBase) / PAGESIZE;
+			if(swapPool[frame].sw_prefetch) {
+				swapPool[frame].sw_prefetch = FALSE;
+				up->u_stats.vm_raHits++;
+				up->u_lastFault = page;
+			} else
+				up->u_stats.vm_softFaults++;
+			swapPool[frame].sw_ref = TRUE;
+			setPte(pte, pte->pte_entryLO | PTEVALID);
+		} else {
+			up->u_stats.vm_faults++;
+			frame = pickVictim();
+			if(swapPool[frame].sw_asid != NOASID)
+				evict(frame, &(up->u_stats));
+			pageIn(frame, owner, page, pte, &(up->u_stats));
+			if(owner == asid)
+				readAhead(asid, page);
+		}
+	}
+
+	SYSCALL(VERHOGEN, (int) &swapSem, 0, 0);
+	LDST(old);
+}
+
+/*
+ * vmPgmHandler - A U-proc's program trap; it is killed
+ */
+void vmPgmHandler() {
+	killUProc(curAsid());
+}
+
+/*
+ * vmSysHandler - Serves SYS9-SYS24 for the U-proc that requested it.
+ * Any other SYSCALL passed up kills the U-proc, as do bad arguments.
+ * The nucleus already stepped the saved PC past the SYSCALL.
+ *
+ * PARAM: a0 = SYSCALL number, a1-a3 = its arguments
+ * RETURN: v0 = per the SYSCALL, see helper methods
+ */
+void vmSysHandler() {
+	int asid = curAsid();
+	state_PTR old = &(uProcs[asid - 1].u_oldTrap[SYSTRAP]);
+
+	switch(old->s_a0) {
+		case READTERMINAL:
+			old->s_v0 = sys9_readTerminal(asid, (char*) old->s_a1);
+			break;
+
+		case WRITETERMINAL:
+			old->s_v0 = sys10_writeTerminal(asid, (char*) old->s_a1,
+				old->s_a2);
+			break;
+
+		case VSEMVIRT:
+			sys11_vSemVirt(asid, (int*) old->s_a1);
+			break;
+
+		case PSEMVIRT:
+			sys12_pSemVirt(asid, (int*) old->s_a1);
+			break;
+
+		case DELAY:
+			sys13_delay(asid, old->s_a1);
+			break;
+
+		case DISK_PUT:
+			old->s_v0 = sys14_diskPut(asid, (memaddr) old->s_a1,
+				old->s_a2, old->s_a3);
+			break;
+
+		case DISK_GET:
+			old->s_v0 = sys15_diskGet(asid, (memaddr) old->s_a1,
+				old->s_a2, old->s_a3);
+			break;
+
+		case WRITEPRINTER:
+			old->s_v0 = sys16_writePrinter(asid, (char*) old->s_a1,
+				old->s_a2);
+			break;
+
+		case GET_TOD:
+			old->s_v0 = sys17_getTOD();
+			break;
+
+		case DISK_FLUSH:
+			old->s_v0 = sys19_diskFlush(asid, old->s_a1);
+			break;
+
+		case DISK_GETV:
+			old->s_v0 = sys20_diskGetV(asid, (diskvec_t*) old->s_a1,
+				old->s_a2, old->s_a3);
+			break;
+
+		case DISK_PUTV:
+			old->s_v0 = sys21_diskPutV(asid, (diskvec_t*) old->s_a1,
+				old->s_a2, old->s_a3);
+			break;
+
+		case DRAINTERMINAL:
+			old->s_v0 = sys22_drainTerminal(asid);
+			break;
+
+		case WAITPRINTJOB:
+			old->s_v0 = sys23_waitPrintJob(asid, old->s_a1);
+			break;
+
+		case DISK_STATS:
+			old->s_v0 = sys24_diskStats(asid, (diskstat_t*) old->s_a1,
+				old->s_a2);
+			break;
+
+		default: /* TERMINATE or an unknown SYSCALL */
+			killUProc(asid);
+	}
+
+	LDST(old);
+}
+
+/*
+ * killUProc - Ends a U-proc: frees its swap pool frames, waits for its
+ * terminal output and print jobs to go out, tells the instantiator &
+ * terminates.
+ * The U-proc may hold no support mutex.
+ * PARAM: asid of the U-proc, which must be the caller
+ */
+void killUProc(int asid) {
+	int i;
+
+	SYSCALL(PASSEREN, (int) &swapSem, 0, 0);
+	for(i = 0; i < SWAPPOOLSIZE; i++) {
+		if(swapPool[i].sw_asid == asid) {
+			setPte(swapPool[i].sw_pte,
+				swapPool[i].sw_pte->pte_entryLO & ~(PTEVALID | PTERESIDENT));
+			swapPool[i].sw_asid = NOASID;
+		}
+	}
+	SYSCALL(VERHOGEN, (int) &swapSem, 0, 0);
+
+	/* The instantiator may end everything next */
+	termDrain(asid - 1);
+	spoolWait(asid - 1, 0);
+	SYSCALL(VERHOGEN, (int) &masterSem, 0, 0);
+	SYSCALL(TERMINATEPROCESS, 0, 0, 0);
+}
+
+/*
+ * delayDaemon - Body of the process waking DELAYed U-procs. Each
+ * pseudo-clock tick it V's the private sema4 of every U-proc due.
+ */
+void delayDaemon() {
+	int asid;
+	cpu_t now;
+
+	while(TRUE) {
+		SYSCALL(WAITCLOCK, 0, 0, 0);
+		SYSCALL(PASSEREN, (int) &adlSem, 0, 0);
+		STCK(now);
+		while((asid = removeExpired(now)) != NOASID)
+			SYSCALL(VERHOGEN, (int) &(uProcs[asid - 1].u_sem), 0, 0);
+		SYSCALL(VERHOGEN, (int) &adlSem, 0, 0);
+	}
+}
+
+/*
+ * cacheFlusher - Body of the process writing the block cache back.
+ * Every FLUSHTICKS pseudo-clock ticks it flushes each disk but the
+ * backing store, which the cache never holds.
+ */
+void cacheFlusher() {
+	int disk, tick;
+
+	while(TRUE) {
+		for(tick = 0; tick < FLUSHTICKS; tick++)
+			SYSCALL(WAITCLOCK, 0, 0, 0);
+		for(disk = BACKINGDISK + 1; disk < DEVPERINT; disk++)
+			flushCache(disk);
+	}
+}
+
+/*
+ * termTxDaemon - Body of the process transmitting a terminal's ring. A
+ * character leaves the ring only once transmitted, so an empty ring
+ * means everything went out; then the drainers are woken and the
+ * daemon waits for more. Writers waiting for room are woken once half
+ * the ring is free.
+ * PARAM: term is the terminal's device number
+ */
+void termTxDaemon(int term) {
+	int* mutex = &(devMutex[DEVSEMINDEX(TERMINT, term, FALSE)]);
+	termring_t* ring = &(txRings[term]);
+	device_t* dev = devReg(TERMINT, term);
+	unsigned int status;
+	char c;
+
+	while(TRUE) {
+		SYSCALL(PASSEREN, (int) mutex, 0, 0);
+		if(ring->tr_count == 0) {
+			while(ring->tr_waiters > 0) {
+				ring->tr_waiters--;
+				SYSCALL(VERHOGEN, (int) &(ring->tr_event), 0, 0);
+			}
+			ring->tr_idle = TRUE;
+			SYSCALL(VERHOGEN, (int) mutex, 0, 0);
+			SYSCALL(PASSEREN, (int) &(ring->tr_work), 0, 0);
+			continue;
+		}
+		c = ring->tr_buf[ring->tr_head];
+		SYSCALL(VERHOGEN, (int) mutex, 0, 0);
+
+		status = doIO(&(dev->t_transm_command),
+			(((unsigned char) c) << TERMCHARSHIFT) | TRANSMITCHAR,
+			TERMINT, term, FALSE) & DEVSTATUSMASK;
+
+		SYSCALL(PASSEREN, (int) mutex, 0, 0);
+		if(status != CHARTRANSMITTED && ring->tr_status == READY)
+			ring->tr_status = -status;
+		ring->tr_head = (ring->tr_head + 1) % TERMRINGSIZE;
+		ring->tr_count--;
+		while(ring->tr_writers > 0 && ring->tr_count <= TERMRINGSIZE / 2) {
+			ring->tr_writers--;
+			SYSCALL(VERHOGEN, (int) &(ring->tr_space), 0, 0);
+		}
+		SYSCALL(VERHOGEN, (int) mutex, 0, 0);
+	}
+}
+
+/*
+ * termRxDaemon - Body of the process collecting a terminal's input.
+ * It keeps the receiver armed while the ring has room, waking readers
+ * on each newline and when the ring fills. After a failed receive it
+ * waits until a reader has been told.
+ * PARAM: term is the terminal's device number
+ */
+void termRxDaemon(int term) {
+	int* mutex = &(devMutex[DEVSEMINDEX(TERMINT, term, TRUE)]);
+	termring_t* ring = &(rxRings[term]);
+	device_t* dev = devReg(TERMINT, term);
+	unsigned int status;
+	char c;
+
+	while(TRUE) {
+		SYSCALL(PASSEREN, (int) mutex, 0, 0);
+		if(ring->tr_count == TERMRINGSIZE || ring->tr_status != READY) {
+			ring->tr_idle = TRUE;
+			SYSCALL(VERHOGEN, (int) mutex, 0, 0);
+			SYSCALL(PASSEREN, (int) &(ring->tr_work), 0, 0);
+			continue;
+		}
+		SYSCALL(VERHOGEN, (int) mutex, 0, 0);
+
+		status = doIO(&(dev->t_recv_command), RECEIVECHAR, TERMINT, term,
+			TRUE);
+
+		SYSCALL(PASSEREN, (int) mutex, 0, 0);
+		if((status & DEVSTATUSMASK) != CHARRECEIVED)
+			ring->tr_status = -(status & DEVSTATUSMASK);
+		else {
+			c = (status >> TERMCHARSHIFT) & DEVSTATUSMASK;
+			ring->tr_buf[(ring->tr_head + ring->tr_count) % TERMRINGSIZE] = c;
+			ring->tr_count++;
+			if(c == '\n')
+				ring->tr_lines++;
+		}
+
+		if(ring->tr_status != READY || ring->tr_lines > 0 ||
+			ring->tr_count == TERMRINGSIZE) {
+			while(ring->tr_waiters > 0) {
+				ring->tr_waiters--;
+				SYSCALL(VERHOGEN, (int) &(ring->tr_event), 0, 0);
+			}
+		}
+		SYSCALL(VERHOGEN, (int) mutex, 0, 0);
+	}
+}
+
+/*
+ * printDaemon - Body of the process printing a printer's spool, a
+ * character per WAITIO. A job is done once its last character is
+ * printed; then the WAITPRINTJOBs are woken to check theirs. Writers
+ * waiting are woken when a job slot frees or half the spool is free.
+ * PARAM: prnt is the printer's device number
+ */
+void printDaemon(int prnt) {
+	int* mutex = &(devMutex[DEVSEMINDEX(PRNTINT, prnt, FALSE)]);
+	spool_t* sp = &(spools[prnt]);
+	device_t* dev = devReg(PRNTINT, prnt);
+	unsigned int status;
+	Bool jobDone;
+	char c;
+
+	while(TRUE) {
+		SYSCALL(PASSEREN, (int) mutex, 0, 0);
+		jobDone = FALSE;
+		while(sp->sp_jobs > 0 && sp->sp_jobLen[sp->sp_jobHead] == 0) {
+			sp->sp_jobHead = (sp->sp_jobHead + 1) % SPOOLJOBS;
+			sp->sp_jobs--;
+			sp->sp_doneJob++;
+			jobDone = TRUE;
+		}
+		if(jobDone) {
+			while(sp->sp_waiters > 0) {
+				sp->sp_waiters--;
+				SYSCALL(VERHOGEN, (int) &(sp->sp_event), 0, 0);
+			}
+		}
+		while(sp->sp_writers > 0 &&
+			(jobDone || sp->sp_count <= SPOOLSIZE / 2)) {
+			sp->sp_writers--;
+			SYSCALL(VERHOGEN, (int) &(sp->sp_space), 0, 0);
+		}
+
+		if(sp->sp_count == 0) {
+			sp->sp_idle = TRUE;
+			SYSCALL(VERHOGEN, (int) mutex, 0, 0);
+			SYSCALL(PASSEREN, (int) &(sp->sp_work), 0, 0);
+			continue;
+		}
+		c = sp->sp_buf[sp->sp_head];
+		SYSCALL(VERHOGEN, (int) mutex, 0, 0);
+
+		dev->d_data0 = (unsigned char) c;
+		status = doIO(&(dev->d_command), PRINTCHAR, PRNTINT, prnt, FALSE) &
+			DEVSTATUSMASK;
+
+		SYSCALL(PASSEREN, (int) mutex, 0, 0);
+		if(status != READY && sp->sp_status == READY)
+			sp->sp_status = -status;
+		sp->sp_head = (sp->sp_head + 1) % SPOOLSIZE;
+		sp->sp_count--;
+		sp->sp_jobLen[sp->sp_jobHead]--;
+		SYSCALL(VERHOGEN, (int) mutex, 0, 0);
+	}
+}
+
+/*
+ * diskDaemon - Body of the process serving a disk's request queue.
+ * Per request V'ed on diskWork it takes the next in C-SCAN order,
+ * with every read of the same sector queued behind it, transfers the
+ * sector once and V's each requester. A request already served by a
+ * merge leaves its diskWork V with nothing to do.
+ * PARAM: disk is the disk's device number
+ */
+void diskDaemon(int disk) {
+	int* mutex = &(devMutex[DEVSEMINDEX(DISKINT, disk, FALSE)]);
+	diskstat_t* stats = &(diskStats[disk]);
+	diskreq_PTR first, req, next;
+	int pos = 0, status;
+	cpu_t startTOD, endTOD;
+
+	while(TRUE) {
+		SYSCALL(PASSEREN, (int) &(diskWork[disk]), 0, 0);
+
+		SYSCALL(PASSEREN, (int) mutex, 0, 0);
+		first = req = removeNextReq(disk, pos);
+		while(req != NULL &&
+			(req->r_next = removeSameRead(disk, first)) != NULL)
+			req = req->r_next;
+		SYSCALL(VERHOGEN, (int) mutex, 0, 0);
+
+		if(first == NULL)
+			continue;
+
+		STCK(startTOD);
+		status = diskIO(disk, first->r_sector, first->r_buf, first->r_cmd);
+		STCK(endTOD);
+		stats->ds_busy += endTOD - startTOD;
+		pos = first->r_sector + 1;
+
+		/* A requester may return as soon as it is V'ed; read r_next first */
+		for(req = first; req != NULL; req = next) {
+			next = req->r_next;
+			if(req != first) {
+				if(status == READY)
+					copyPage(first->r_buf, req->r_buf);
+				stats->ds_merged++;
+			}
+			req->r_status = status;
+			stats->ds_requests++;
+			stats->ds_sumLatency += endTOD - req->r_queued;
+			stats->ds_maxLatency = MAX(stats->ds_maxLatency,
+				endTOD - req->r_queued);
+			SYSCALL(VERHOGEN, (int) &(req->r_done), 0, 0);
+		}
+	}
+}
+
+/*
+ * devReg - Finds a device's register
+ * PARAM: lineNum is the device's interrupt line, deviceNum its number
+ * RETURN: the device register
+ */
+device_t* devReg(int lineNum, int deviceNum) {
+	devregarea_t* bus = (devregarea_t*) RAMBASEADDR;
+
+	return &(bus->devreg[(lineNum - LINENUMOFFSET) * DEVPERINT + deviceNum]);
+}
+
+/*
+ * doIO - Issues a device command and waits for its completion.
+ * Interrupts are off from the command until the WAITIO blocks, so the
+ * completion cannot be taken before anyone waits for it.
+ * PARAM: cmdReg is the command field of the device register
+ *        cmd is the command
+ *        lineNum, deviceNum & isReadTerm are as for WAITIO
+ * RETURN: the device status
+ */
+unsigned int doIO(unsigned int* cmdReg, unsigned int cmd,
+	int lineNum, int deviceNum, Bool isReadTerm) {
+	unsigned int status, oldStatus;
+
+	oldStatus = getSTATUS();
+	setSTATUS(oldStatus & ~INTcON);
+	*cmdReg = cmd;
+	status = SYSCALL(WAITIO, lineNum, deviceNum, isReadTerm);
+	setSTATUS(oldStatus);
+
+	return status;
+}
+
+/*
+ * diskRequest - Queues a transfer for a disk's daemon and waits for it
+ * PARAM: disk is the disk's device number
+ *        sector is the sector's linear number, cylinder major
+ *        buf is a page of physical memory
+ *        cmd is DISKREAD or DISKWRITE
+ * RETURN: READY, or minus the failed status (-DISKSEEKERR for a sector
+ *         beyond the disk or a disk not installed)
+ */
+int diskRequest(int disk, int sector, memaddr buf, int cmd) {
+	diskreq_t req;
+
+	if(!devInstalled(DISKINT, disk))
+		return -DISKSEEKERR;
+
+	req.r_sector = sector;
+	req.r_buf = buf;
+	req.r_cmd = cmd;
+	diskSubmit(disk, &req);
+	return diskWait(&req);
+}
+
+/*
+ * flushCache - Writes a disk's dirty cache buffers back, queueing
+ * every write before waiting on any so the daemon takes them in one
+ * sweep. The buffers are busy meanwhile and cacheSem released, so the
+ * rest of the cache stays usable. A buffer whose write fails is dirty
+ * again.
+ * PARAM: disk is the disk's device number
+ * RETURN: READY, or minus the first failed status
+ */
+int flushCache(int disk) {
+	bcache_PTR blocks[BCACHESIZE];
+	diskreq_t reqs[BCACHESIZE];
+	int count, i, result = READY;
+
+	SYSCALL(PASSEREN, (int) &cacheSem, 0, 0);
+	count = dirtyBlocks(disk, blocks);
+	for(i = 0; i < count; i++) {
+		blocks[i]->b_busy = TRUE;
+		blocks[i]->b_dirty = FALSE;
+	}
+	SYSCALL(VERHOGEN, (int) &cacheSem, 0, 0);
+
+	for(i = 0; i < count; i++) {
+		reqs[i].r_sector = blocks[i]->b_sector;
+		reqs[i].r_buf = blocks[i]->b_buf;
+		reqs[i].r_cmd = DISKWRITE;
+		diskSubmit(disk, &(reqs[i]));
+	}
+	for(i = 0; i < count; i++)
+		reqs[i].r_status = diskWait(&(reqs[i]));
+
+	SYSCALL(PASSEREN, (int) &cacheSem, 0, 0);
+	for(i = 0; i < count; i++) {
+		if(reqs[i].r_status == READY)
+			cacheStats.cs_writeBacks++;
+		else {
+			blocks[i]->b_dirty = TRUE;
+			if(result == READY)
+				result = reqs[i].r_status;
+		}
+		releaseBlock(blocks[i]);
+	}
+	SYSCALL(VERHOGEN, (int) &cacheSem, 0, 0);
+
+	return result;
+}
+
+/*
+ * backingSector - Where a page lives on the backing store, per the
+ * owner's extent (see initProc's initSwapSpace)
+ * PARAM: owner is the page's ASID, SHAREDASID for kUseg3
+ *        page is its index in the owner's page table
+ * RETURN: the disk0 sector
+ */
+int backingSector(int owner, int page) {
+	if(!SEEKAWARESWAP)
+		return page * (MAXUPROC + 1) + swapExtents[owner].se_start;
+
+	return swapExtents[owner].se_start + page;
+}
+
+/*
+ * reportVM - Writes each U-proc's pager counters to terminal 0, with
+ * its mean page-in latency in μ seconds and its swap extent, then each
+ * disk's scheduler counters, latencies & busy time in μ seconds, and
+ * the block cache's counters. Returns once all of it is transmitted.
+ * Called by the instantiator once every U-proc has ended.
+ */
+void reportVM() {
+	char line[192];
+	int asid, disk, len;
+	vmstat_PTR stats;
+	diskstat_t* ds;
+
+	for(asid = 1; asid <= MAXUPROC; asid++) {
+		stats = &(uProcs[asid - 1].u_stats);
+		if(stats->vm_faults == 0)
+			continue; /* never ran */
+
+		len = appendField(line, 0, "asid ", asid);
+		len = appendField(line, len, ": faults ", stats->vm_faults);
+		len = appendField(line, len, " soft ", stats->vm_softFaults);
+		len = appendField(line, len, " in ", stats->vm_pageIns);
+		len = appendField(line, len, " out ", stats->vm_pageOuts);
+		len = appendField(line, len, " clean ", stats->vm_cleanDrops);
+		len = appendField(line, len, " ahead ", stats->vm_raPages);
+		len = appendField(line, len, " hits ", stats->vm_raHits);
+		if(stats->vm_pageIns > 0)
+			len = appendField(line, len, " avgin ",
+				stats->vm_inTime / stats->vm_pageIns);
+		len = appendField(line, len, " swap ", swapExtents[asid].se_start);
+		line[len++] = '\n';
+
+		termWrite(0, line, len);
+	}
+
+	for(disk = 0; disk < DEVPERINT; disk++) {
+		ds = &(diskStats[disk]);
+		if(ds->ds_requests == 0)
+			continue;
+
+		len = appendField(line, 0, "disk ", disk);
+		len = appendField(line, len, ": reqs ", ds->ds_requests);
+		len = appendField(line, len, " merged ", ds->ds_merged);
+		len = appendField(line, len, " seeks ", ds->ds_seeks);
+		len = appendField(line, len, " avglat ",
+			ds->ds_sumLatency / ds->ds_requests);
+		len = appendField(line, len, " maxlat ", ds->ds_maxLatency);
+		len = appendField(line, len, " busy ", ds->ds_busy);
+		line[len++] = '\n';
+
+		termWrite(0, line, len);
+	}
+
+	if(cacheStats.cs_hits + cacheStats.cs_misses + cacheStats.cs_puts > 0) {
+		len = appendField(line, 0, "cache: hits ", cacheStats.cs_hits);
+		len = appendField(line, len, " misses ", cacheStats.cs_misses);
+		len = appendField(line, len, " puts ", cacheStats.cs_puts);
+		len = appendField(line, len, " writebacks ", cacheStats.cs_writeBacks);
+		line[len++] = '\n';
+
+		termWrite(0, line, len);
+	}
+
+	termDrain(0); /* before the instantiator ends and its daemons with it */
+}
+
+/********************** Helper Methods **********************/
+/*
+ * curAsid - The running U-proc's ASID, from EntryHi
+ */
+HIDDEN int curAsid() {
+	return (getENTRYHI() & ASIDMASK) >> ASIDSHIFT;
+}
+
+/*
+ * findPte - Finds the page table entry mapping a virtual page
+ * PARAM: asid of the faulting U-proc
+ *        vpn is the virtual page number
+ *        owner is set to the page's ASID, SHAREDASID for kUseg3
+ *        page is set to the entry's index in its page table
+ * RETURN: the entry, NULL if vpn is in no page table
+ */
+HIDDEN pte_PTR findPte(int asid, unsigned int vpn, int* owner, int* page) {
+	unsigned int seg2 = KUSEG2ADDR >> VPNSHIFT, seg3 = KUSEG3ADDR >> VPNSHIFT;
+
+	if(vpn >= seg3 && vpn < seg3 + KUSEGPTESIZE) {
+		*owner = SHAREDASID;
+		*page = vpn - seg3;
+		return &(kUseg3Pte.pt_entries[*page]);
+	}
+
+	if(vpn == STACKVPN)
+		*page = STACKPAGE;
+	else if(vpn >= seg2 && vpn < seg2 + KUSEG2PAGES)
+		*page = vpn - seg2;
+	else
+		return NULL;
+
+	*owner = asid;
+	return &(uProcs[asid - 1].u_pte.pt_entries[*page]);
+}
+
+/*
+ * setPte - Changes a page table entry's entryLO and flushes the TLB,
+ * with interrupts off so no U-proc runs on a stale translation
+ */
+HIDDEN void setPte(pte_PTR pte, unsigned int entryLO) {
+	unsigned int oldStatus = getSTATUS();
+
+	setSTATUS(oldStatus & ~INTcON);
+	pte->pte_entryLO = entryLO;
+	TLBCLR();
+	setSTATUS(oldStatus);
+}
+
+/*
+ * pickVictim - Second-chance clock over the swap pool.
+ * A referenced frame loses its reference and its V bit and is passed
+ * over; the first free or unreferenced frame is the victim. After one
+ * sweep every frame is unreferenced, so at most two are needed. Pinned
+ * frames are skipped; at most MAXPINNED are, fewer than the pool.
+ * The caller holds swapSem.
+ * RETURN: index of the frame to fill
+ */
+HIDDEN int pickVictim() {
+	int frame;
+	swap_t* sw;
+
+	while(TRUE) {
+		frame = clockHand;
+		clockHand = (clockHand + 1) % SWAPPOOLSIZE;
+		sw = &(swapPool[frame]);
+
+		if(sw->sw_asid != NOASID && sw->sw_pinned > 0)
+			continue; /* a disk is transferring to or from it */
+
+		if(sw->sw_asid == NOASID || !sw->sw_ref)
+			return frame;
+
+		sw->sw_ref = FALSE;
+		setPte(sw->sw_pte, sw->sw_pte->pte_entryLO & ~PTEVALID);
+	}
+}
+
+/*
+ * freeFrame - Finds a swap pool frame holding no page, without
+ * evicting anything. The caller holds swapSem.
+ * RETURN: its index, NOFRAME if the pool is full
+ */
+HIDDEN int freeFrame() {
+	int frame;
+
+	for(frame = 0; frame < SWAPPOOLSIZE; frame++) {
+		if(swapPool[frame].sw_asid == NOASID)
+			return frame;
+	}
+
+	return NOFRAME;
+}
+
+/*
+ * diskIO - Seeks and transfers one sector between a disk and a page
+ * of physical memory. The seek is skipped when the head is already on
+ * the sector's cylinder. Only the disk's daemon calls it.
+ * PARAM: disk is the disk's device number
+ *        sector is the sector's linear number, cylinder major
+ *        buf is the page's physical address
+ *        cmd is DISKREAD or DISKWRITE
+ * RETURN: READY, or minus the failed status (-DISKSEEKERR for a sector
+ *         beyond the disk)
+ */
+HIDDEN int diskIO(int disk, int sector, memaddr buf, int cmd) {
+	device_t* dev = devReg(DISKINT, disk);
+	int maxCyl, maxHead, maxSect, cyl, head, sect;
+	unsigned int status;
+
+	maxCyl = dev->d_data1 >> DISKCYLSHIFT;
+	maxHead = (dev->d_data1 >> DISKHEADSHIFT) & DISKFIELDMASK;
+	maxSect = dev->d_data1 & DISKFIELDMASK;
+
+	if(sector < 0 || sector >= maxCyl * maxHead * maxSect)
+		return -DISKSEEKERR;
+
+	cyl = sector / (maxHead * maxSect);
+	head = (sector / maxSect) % maxHead;
+	sect = sector % maxSect;
+
+	status = READY;
+	if(diskCyl[disk] != cyl) {
+		status = doIO(&(dev->d_command), (cyl << SEEKCYLSHIFT) | DISKSEEK,
+			DISKINT, disk, FALSE) & DEVSTATUSMASK;
+		diskStats[disk].ds_seeks++;
+		diskCyl[disk] = (status == READY) ? cyl : -1;
+	}
+
+	if(status == READY) {
+		dev->d_data0 = buf;
+		status = doIO(&(dev->d_command),
+			(head << BLKHEADSHIFT) | (sect << BLKSECTSHIFT) | cmd,
+			DISKINT, disk, FALSE) & DEVSTATUSMASK;
+	}
+
+	return (status == READY) ? READY : -status;
+}
+
+/*
+ * diskSubmit - Queues a request for a disk's daemon without waiting.
+ * The request must stay put until diskWait returns.
+ * PARAM: disk is the disk's device number, installed
+ *        req has r_sector, r_buf & r_cmd filled in
+ */
+HIDDEN void diskSubmit(int disk, diskreq_PTR req) {
+	int* mutex = &(devMutex[DEVSEMINDEX(DISKINT, disk, FALSE)]);
+
+	req->r_done = 0;
+	STCK(req->r_queued);
+
+	SYSCALL(PASSEREN, (int) mutex, 0, 0);
+	insertDiskReq(disk, req);
+	SYSCALL(VERHOGEN, (int) mutex, 0, 0);
+
+	SYSCALL(VERHOGEN, (int) &(diskWork[disk]), 0, 0);
+}
+
+/*
+ * diskWait - Waits for a submitted request to be served
+ * RETURN: its status, as diskIO returns it
+ */
+HIDDEN int diskWait(diskreq_PTR req) {
+	SYSCALL(PASSEREN, (int) &(req->r_done), 0, 0);
+	return req->r_status;
+}
+
+/*
+ * devInstalled - Whether a device is installed, and so has a daemon
+ * if it is a disk or a terminal
+ * PARAM: lineNum is the device's interrupt line, deviceNum its number
+ */
+HIDDEN Bool devInstalled(int lineNum, int deviceNum) {
+	devregarea_t* bus = (devregarea_t*) RAMBASEADDR;
+
+	if(deviceNum < 0 || deviceNum >= DEVPERINT)
+		return FALSE;
+	return (bus->inst_dev[lineNum - LINENUMOFFSET] & (1 << deviceNum)) != 0;
+}
+
+/*
+ * diskSectors - How many sectors a disk has, 0 if not installed
+ */
+HIDDEN int diskSectors(int disk) {
+	device_t* dev = devReg(DISKINT, disk);
+
+	if(!devInstalled(DISKINT, disk))
+		return 0;
+	return (dev->d_data1 >> DISKCYLSHIFT) *
+		((dev->d_data1 >> DISKHEADSHIFT) & DISKFIELDMASK) *
+		(dev->d_data1 & DISKFIELDMASK);
+}
+
+/*
+ * findBlock - Finds the cache buffer holding a sector, waiting out a
+ * transfer that has it busy. The caller holds cacheSem, which is
+ * released while it waits.
+ * PARAM: disk & sector name the sector
+ * RETURN: the buffer, not busy; NULL on a miss
+ */
+HIDDEN bcache_PTR findBlock(int disk, int sector) {
+	bcache_PTR b;
+
+	while((b = lookupBlock(disk, sector)) != NULL && b->b_busy) {
+		cacheWaiters++;
+		SYSCALL(VERHOGEN, (int) &cacheSem, 0, 0);
+		SYSCALL(PASSEREN, (int) &cacheWait, 0, 0);
+		SYSCALL(PASSEREN, (int) &cacheSem, 0, 0);
+	}
+
+	return b;
+}
+
+/*
+ * releaseBlock - Ends a transfer's hold on a busy cache buffer and
+ * wakes whoever waits on one, to look again. The caller holds cacheSem.
+ */
+HIDDEN void releaseBlock(bcache_PTR b) {
+	b->b_busy = FALSE;
+	for(; cacheWaiters > 0; cacheWaiters--)
+		SYSCALL(VERHOGEN, (int) &cacheWait, 0, 0);
+}
+
+/*
+ * claimBlock - Reuses the least recently used cache buffer for a
+ * sector. A dirty one is written back first, busy and with cacheSem
+ * released, so the sector may be cached by someone else meanwhile.
+ * The caller holds cacheSem and has found no buffer holding the sector.
+ * PARAM: disk & sector name what the buffer is to hold
+ * RETURN: the buffer, clean and holding nothing yet; NULL if every
+ *         buffer is busy, a write-back failed or the sector is now
+ *         cached, which the caller looks for again
+ */
+HIDDEN bcache_PTR claimBlock(int disk, int sector) {
+	bcache_PTR b;
+	int status;
+
+	while((b = lruBlock()) != NULL && b->b_dirty) {
+		b->b_busy = TRUE;
+		b->b_dirty = FALSE;
+		SYSCALL(VERHOGEN, (int) &cacheSem, 0, 0);
+		status = diskRequest(b->b_disk, b->b_sector, b->b_buf, DISKWRITE);
+		SYSCALL(PASSEREN, (int) &cacheSem, 0, 0);
+
+		if(status != READY)
+			b->b_dirty = TRUE;
+		else
+			cacheStats.cs_writeBacks++;
+		releaseBlock(b);
+		if(status != READY || lookupBlock(disk, sector) != NULL)
+			return NULL;
+	}
+
+	if(b != NULL)
+		setBlock(b, disk, sector);
+	return b;
+}
+
+/*
+ * diskUser - Transfers a sector to or from a U-proc's page. A page
+ * aligned page is used in place, pinned for the transfer; any other is
+ * staged through the U-proc's DMA buffer. A failed read leaves a page
+ * used in place undefined, as the disk may have written part of it; a
+ * staged page is left as it was.
+ * PARAM: asid of the U-proc, the caller
+ *        buf is its page, already validated
+ *        disk & sector name the sector, cmd is DISKREAD or DISKWRITE
+ * RETURN: READY, or minus the failed status
+ */
+HIDDEN int diskUser(int asid, memaddr buf, int disk, int sector, int cmd) {
+	memaddr dmaBuf = dmaBufBase + (asid - 1) * PAGESIZE, frame;
+	int status;
+
+	if(PAGEALIGNED(buf)) {
+		reservePins(1);
+		frame = pinUser(asid, buf, cmd == DISKREAD);
+		status = diskRequest(disk, sector, frame, cmd);
+		unpinUser(frame);
+		return status;
+	}
+
+	if(cmd == DISKWRITE)
+		copyPage(buf, dmaBuf);
+	status = diskRequest(disk, sector, dmaBuf, cmd);
+	if(cmd == DISKREAD && status == READY)
+		copyPage(dmaBuf, buf);
+	return status;
+}
+
+/*
+ * pinUser - Faults a U-proc's page in and pins its frame, one of the
+ * pins the caller reserved. A page the disk is to write into is stored
+ * to first, so the pager marks it dirty; the disk's DMA bypasses the
+ * TLB and would not.
+ * PARAM: asid of the U-proc, the caller
+ *        buf is its page, validated and page aligned
+ *        willWrite is TRUE if the disk is to write into it
+ * RETURN: the frame's physical address
+ */
+HIDDEN memaddr pinUser(int asid, memaddr buf, Bool willWrite) {
+	volatile unsigned int* word = (unsigned int*) buf;
+	int owner, page;
+	pte_PTR pte = findPte(asid, buf >> VPNSHIFT, &owner, &page);
+	memaddr frame;
+
+	while(TRUE) {
+		if(willWrite)
+			*word = *word;
+		else
+			(void) *word;
+
+		/* Unless evicted since; then fault it in again */
+		SYSCALL(PASSEREN, (int) &swapSem, 0, 0);
+		if((pte->pte_entryLO & PTERESIDENT) &&
+			(!willWrite || (pte->pte_entryLO & PTEDIRTY)))
+			break;
+		SYSCALL(VERHOGEN, (int) &swapSem, 0, 0);
+	}
+
+	frame = pte->pte_entryLO & PFNMASK;
+	swapPool[(frame - swapPoolBase) / PAGESIZE].sw_pinned++;
+	SYSCALL(VERHOGEN, (int) &swapSem, 0, 0);
+
+	return frame;
+}
+
+/*
+ * unpinUser - Lets the clock have a frame pinUser pinned again, and
+ * gives its pin back
+ * PARAM: frame is the physical address pinUser returned
+ */
+HIDDEN void unpinUser(memaddr frame) {
+	SYSCALL(PASSEREN, (int) &swapSem, 0, 0);
+	swapPool[(frame - swapPoolBase) / PAGESIZE].sw_pinned--;
+	SYSCALL(VERHOGEN, (int) &swapSem, 0, 0);
+
+	SYSCALL(VERHOGEN, (int) &pinSem, 0, 0);
+}
+
+/*
+ * reservePins - Waits until count more frames may be pinned. All of
+ * them are taken under pinMutex, so no two U-procs each hold part of
+ * what they need while waiting for the rest.
+ * PARAM: count is at most MAXPINNED
+ */
+HIDDEN void reservePins(int count) {
+	int i;
+
+	SYSCALL(PASSEREN, (int) &pinMutex, 0, 0);
+	for(i = 0; i < count; i++)
+		SYSCALL(PASSEREN, (int) &pinSem, 0, 0);
+	SYSCALL(VERHOGEN, (int) &pinMutex, 0, 0);
+}
+
+/*
+ * diskVector - Serves DISK_GETV & DISK_PUTV. Reads the block cache
+ * holds are copied from it; a write updates any cached copy and goes
+ * on to the disk, noted with writeStarted so no miss caches what the
+ * write replaces. Unaligned pages are transferred one at a time, the
+ * rest pinned and queued together, then waited on.
+ * PARAM: asid of the U-proc, the caller
+ *        vec, count is its vector, validated here
+ *        disk is the disk's device number, not the backing store's
+ *        cmd is DISKREAD or DISKWRITE
+ * RETURN: READY, or minus the first failed segment's status
+ */
+HIDDEN int diskVector(int asid, diskvec_t* vec, int count, int disk,
+	int cmd) {
+	diskreq_t reqs[MAXDISKVEC];
+	memaddr frames[MAXDISKVEC];
+	int queued[MAXDISKVEC], pins = 0, i, result = READY;
+	bcache_PTR b;
+
+	if(disk <= BACKINGDISK || disk >= DEVPERINT || count < 0 ||
+		count > MAXDISKVEC ||
+		!validUser((memaddr) vec, count * sizeof(diskvec_t)))
+		killUProc(asid);
+	for(i = 0; i < count; i++) {
+		if(!validUser(vec[i].dv_buf, PAGESIZE))
+			killUProc(asid);
+		if(PAGEALIGNED(vec[i].dv_buf))
+			pins++;
+	}
+
+	if(!devInstalled(DISKINT, disk)) {
+		for(i = 0; i < count; i++)
+			vec[i].dv_status = -DISKSEEKERR;
+		return (count > 0) ? -DISKSEEKERR : READY;
+	}
+
+	reservePins(pins);
+	for(i = 0; i < count; i++) {
+		queued[i] = FALSE;
+
+		SYSCALL(PASSEREN, (int) &cacheSem, 0, 0);
+		b = findBlock(disk, vec[i].dv_sector);
+		if(cmd == DISKWRITE)
+			writeStarted(disk);
+		if(b != NULL) {
+			if(cmd == DISKREAD)
+				copyPage(b->b_buf, vec[i].dv_buf);
+			else
+				copyPage(vec[i].dv_buf, b->b_buf);
+			touchBlock(b);
+		}
+		if(cmd == DISKREAD && b != NULL)
+			cacheStats.cs_hits++;
+		else if(cmd == DISKREAD)
+			cacheStats.cs_misses++;
+		SYSCALL(VERHOGEN, (int) &cacheSem, 0, 0);
+
+		if(cmd == DISKREAD && b != NULL)
+			vec[i].dv_status = READY;
+		else if(!PAGEALIGNED(vec[i].dv_buf))
+			vec[i].dv_status = diskUser(asid, vec[i].dv_buf, disk,
+				vec[i].dv_sector, cmd);
+		else {
+			frames[i] = pinUser(asid, vec[i].dv_buf, cmd == DISKREAD);
+			reqs[i].r_sector = vec[i].dv_sector;
+			reqs[i].r_buf = frames[i];
+			reqs[i].r_cmd = cmd;
+			diskSubmit(disk, &(reqs[i]));
+			queued[i] = TRUE;
+			pins--;
+		}
+	}
+
+	/* Pins reserved for reads the cache served */
+	for(i = 0; i < pins; i++)
+		SYSCALL(VERHOGEN, (int) &pinSem, 0, 0);
+
+	for(i = 0; i < count; i++) {
+		if(queued[i]) {
+			vec[i].dv_status = diskWait(&(reqs[i]));
+			unpinUser(frames[i]);
+		}
+		if(vec[i].dv_status != READY && result == READY)
+			result = vec[i].dv_status;
+	}
+
+	if(cmd == DISKWRITE) {
+		SYSCALL(PASSEREN, (int) &cacheSem, 0, 0);
+		for(i = 0; i < count; i++)
+			writeDone(disk);
+		SYSCALL(VERHOGEN, (int) &cacheSem, 0, 0);
+	}
+
+	return result;
+}
+
+/*
+ * readAhead - Adapts a U-proc's readahead window to a fault and reads
+ * that many of the following pages into free frames, queueing every
+ * read before waiting on any so the disk daemon takes them in one
+ * sweep. Stops at the first page already resident, with no copy on the
+ * backing store, or when no frame is free.
+ * The caller holds swapSem.
+ * PARAM: asid of the faulting U-proc
+ *        page is the kUseg2 page it just faulted in
+ */
+HIDDEN void readAhead(int asid, int page) {
+	uproc_PTR up = &(uProcs[asid - 1]);
+	diskreq_t reqs[RAMAXWINDOW];
+	int frames[RAMAXWINDOW];
+	int count, i;
+	cpu_t startTOD, endTOD;
+	pte_PTR pte;
+	swap_t* sw;
+
+	if(page == up->u_lastFault + 1)
+		up->u_raWindow = MIN(MAX(2 * up->u_raWindow, 1), RAMAXWINDOW);
+	else
+		up->u_raWindow /= 2;
+	up->u_lastFault = page;
+
+	STCK(startTOD);
+	for(count = 0; count < up->u_raWindow &&
+		page + 1 + count < KUSEG2PAGES; count++) {
+		pte = &(up->u_pte.pt_entries[page + 1 + count]);
+		frames[count] = freeFrame();
+		if((pte->pte_entryLO & PTERESIDENT) ||
+			(pte->pte_entryLO & PTEONDISK) == 0 || frames[count] == NOFRAME)
+			break;
+
+		/* Claimed now so freeFrame moves on; mapped once it is read */
+		sw = &(swapPool[frames[count]]);
+		sw->sw_asid = asid;
+		sw->sw_page = page + 1 + count;
+		sw->sw_pte = pte;
+		sw->sw_ref = FALSE;
+		sw->sw_prefetch = TRUE;
+
+		reqs[count].r_sector = backingSector(asid, page + 1 + count);
+		reqs[count].r_buf = frameAddr(frames[count]);
+		reqs[count].r_cmd = DISKREAD;
+		diskSubmit(BACKINGDISK, &(reqs[count]));
+	}
+
+	for(i = 0; i < count; i++) {
+		if(diskWait(&(reqs[i])) != READY)
+			PANIC();
+
+		pte = swapPool[frames[i]].sw_pte;
+		setPte(pte, (pte->pte_entryLO & ~(PFNMASK | PTEDIRTY)) |
+			frameAddr(frames[i]) | PTERESIDENT);
+		up->u_stats.vm_pageIns++;
+		up->u_stats.vm_raPages++;
+	}
+	STCK(endTOD);
+	if(count > 0)
+		up->u_stats.vm_inTime += endTOD - startTOD;
+}
+
+/*
+ * evict - Unmaps a frame's page and, if dirty, writes it to the
+ * backing store. The caller holds swapSem.
+ * PARAM: frame is the swap pool index
+ *        stats are the faulting U-proc's counters
+ */
+HIDDEN void evict(int frame, vmstat_PTR stats) {
+	swap_t* sw = &(swapPool[frame]);
+	int sector = backingSector(sw->sw_asid, sw->sw_page), status;
+
+	setPte(sw->sw_pte, sw->sw_pte->pte_entryLO & ~(PTEVALID | PTERESIDENT));
+
+	/* Read ahead for nothing; its owner reads less far from now on */
+	if(sw->sw_prefetch)
+		uProcs[sw->sw_asid - 1].u_raWindow /= 2;
+	sw->sw_asid = NOASID;
+
+	if((sw->sw_pte->pte_entryLO & PTEDIRTY) == 0) {
+		stats->vm_cleanDrops++;
+		return;
+	}
+
+	status = diskRequest(BACKINGDISK, sector, frameAddr(frame), DISKWRITE);
+	if(status != READY)
+		PANIC(); /* the page is lost */
+
+	sw->sw_pte->pte_entryLO |= PTEONDISK;
+	sw->sw_pte->pte_entryLO &= ~PTEDIRTY;
+	stats->vm_pageOuts++;
+}
+
+/*
+ * pageIn - Fills a free frame with a page and maps it clean. A page
+ * never written to the backing store starts zeroed.
+ * The caller holds swapSem.
+ * PARAM: frame is the swap pool index
+ *        owner & page name the page, as findPte sets them
+ *        pte is its page table entry
+ *        stats are the faulting U-proc's counters
+ */
+HIDDEN void pageIn(int frame, int owner, int page, pte_PTR pte,
+	vmstat_PTR stats) {
+	swap_t* sw = &(swapPool[frame]);
+	memaddr addr = frameAddr(frame);
+	int status, i;
+	cpu_t startTOD, endTOD;
+
+	if(pte->pte_entryLO & PTEONDISK) {
+		STCK(startTOD);
+		status = diskRequest(BACKINGDISK, backingSector(owner, page), addr,
+			DISKREAD);
+		if(status != READY)
+			PANIC();
+		STCK(endTOD);
+		stats->vm_inTime += endTOD - startTOD;
+		stats->vm_pageIns++;
+	} else {
+		for(i = 0; i < PAGESIZE / WORDLEN; i++)
+			((unsigned int*) addr)[i] = 0;
+	}
+
+	sw->sw_asid = owner;
+	sw->sw_page = page;
+	sw->sw_pte = pte;
+	sw->sw_ref = TRUE;
+	sw->sw_prefetch = FALSE;
+	setPte(pte, (pte->pte_entryLO & ~(PFNMASK | PTEDIRTY)) | addr |
+		PTEVALID | PTERESIDENT);
+}
+
+/*
+ * frameAddr - Physical address of a swap pool frame
+ */
+HIDDEN memaddr frameAddr(int frame) {
+	return swapPoolBase + frame * PAGESIZE;
+}
+
+/*
+ * whichRegion - Which mapped part of a U-proc's address space holds
+ * an address: 1 for kUseg2 text & data, 2 for its stack page,
+ * 3 for kUseg3, 0 for none
+ */
+HIDDEN int whichRegion(memaddr addr) {
+	if(addr >= KUSEG2ADDR && addr < KUSEG2ADDR + KUSEG2PAGES * PAGESIZE)
+		return 1;
+	if(addr >= (STACKVPN << VPNSHIFT) && addr < UPROCSTACK)
+		return 2;
+	if(addr >= KUSEG3ADDR && addr - KUSEG3ADDR < KUSEGPTESIZE * PAGESIZE)
+		return 3;
+	return 0;
+}
+
+/*
+ * validUser - Checks a U-proc's buffer lies within one mapped region,
+ * so touching it can page fault but never kill the U-proc while it
+ * holds a support level mutex
+ * PARAM: addr is the buffer's first byte, len its length
+ */
+HIDDEN Bool validUser(memaddr addr, int len) {
+	int region = whichRegion(addr);
+
+	if(len < 0 || len > KUSEGPTESIZE * PAGESIZE || region == 0)
+		return FALSE;
+
+	return len == 0 || whichRegion(addr + len - 1) == region;
+}
+
+/*
+ * copyPage - Copies a page word by word
+ */
+HIDDEN void copyPage(memaddr from, memaddr to) {
+	int i;
+
+	for(i = 0; i < PAGESIZE / WORDLEN; i++)
+		((unsigned int*) to)[i] = ((unsigned int*) from)[i];
+}
+
+/*
+ * Reads a line from the U-proc's terminal into its buffer, newline
+ * included. The terminal's receive daemon has been collecting input all
+ * along, so a line already typed is served at once; otherwise the
+ * U-proc waits for the newline. A ring filled without one is returned
+ * whole, as a partial line.
+ *
+ * EX: int SYSCALL (READTERMINAL, char *virtAddr)
+ *    Where the mnemonic constant READTERMINAL has the value of 9.
+ * PARAM: a1 = buffer of at least a line, in kUseg2 or kUseg3
+ * RETURN: v0 = characters read, or minus the failed receive status
+ */
+HIDDEN int sys9_readTerminal(int asid, char* buf) {
+	int term = asid - 1, count = 0, status;
+	int* mutex = &(devMutex[DEVSEMINDEX(TERMINT, term, TRUE)]);
+	termring_t* ring = &(rxRings[term]);
+	char c;
+
+	if(!devInstalled(TERMINT, term))
+		return -UNINSTALLED;
+
+	SYSCALL(PASSEREN, (int) mutex, 0, 0);
+	while(ring->tr_lines == 0 && ring->tr_count < TERMRINGSIZE &&
+		ring->tr_status == READY) {
+		ring->tr_waiters++;
+		SYSCALL(VERHOGEN, (int) mutex, 0, 0);
+		SYSCALL(PASSEREN, (int) &(ring->tr_event), 0, 0);
+		SYSCALL(PASSEREN, (int) mutex, 0, 0);
+	}
+
+	if(ring->tr_lines == 0 && ring->tr_count < TERMRINGSIZE) {
+		/* The receiver failed; report it and let the daemon go on */
+		status = ring->tr_status;
+		ring->tr_status = READY;
+		count = status;
+	} else {
+		do {
+			if(!validUser((memaddr) &buf[count], 1)) {
+				SYSCALL(VERHOGEN, (int) mutex, 0, 0);
+				killUProc(asid);
+			}
+			c = ring->tr_buf[ring->tr_head];
+			ring->tr_head = (ring->tr_head + 1) % TERMRINGSIZE;
+			ring->tr_count--;
+			buf[count++] = c;
+		} while(c != '\n' && ring->tr_count > 0);
+
+		if(c == '\n')
+			ring->tr_lines--;
+	}
+
+	if(ring->tr_idle) {
+		ring->tr_idle = FALSE;
+		SYSCALL(VERHOGEN, (int) &(ring->tr_work), 0, 0);
+	}
+	SYSCALL(VERHOGEN, (int) mutex, 0, 0);
+
+	return count;
+}
+
+/*
+ * Writes a string to the U-proc's terminal. It is queued on the
+ * terminal's transmit ring and the U-proc goes on, blocking only while
+ * the ring is full; DRAINTERMINAL waits for it to go out.
+ *
+ * EX: int SYSCALL (WRITETERMINAL, char *virtAddr, int len)
+ *    Where the mnemonic constant WRITETERMINAL has the value of 10.
+ * PARAM: a1 = the string, in kUseg2 or kUseg3
+ *        a2 = its length
+ * RETURN: v0 = len, 0 if the terminal is not installed
+ */
+HIDDEN int sys10_writeTerminal(int asid, char* str, int len) {
+	if(!validUser((memaddr) str, len))
+		killUProc(asid);
+
+	return termWrite(asid - 1, str, len);
+}
+
+/*
+ * V's a virtual semaphore, waking the U-proc blocked longest on it.
+ *
+ * EX: void SYSCALL (VSEMVIRT, int *semaddr)
+ *    Where the mnemonic constant VSEMVIRT has the value of 11.
+ * PARAM: a1 = the semaphore, which must be in kUseg3
+ */
+HIDDEN void sys11_vSemVirt(int asid, int* semAdd) {
+	int waker = NOASID;
+
+	if(whichRegion((memaddr) semAdd) != 3 || !ALIGNED(semAdd))
+		killUProc(asid);
+
+	SYSCALL(PASSEREN, (int) &avslSem, 0, 0);
+	(*semAdd)++;
+	if(*semAdd <= 0)
+		waker = removeVirtBlocked(semAdd);
+	SYSCALL(VERHOGEN, (int) &avslSem, 0, 0);
+
+	if(waker != NOASID)
+		SYSCALL(VERHOGEN, (int) &(uProcs[waker - 1].u_sem), 0, 0);
+}
+
+/*
+ * P's a virtual semaphore, blocking the U-proc on its private sema4
+ * if it goes negative.
+ *
+ * EX: void SYSCALL (PSEMVIRT, int *semaddr)
+ *    Where the mnemonic constant PSEMVIRT has the value of 12.
+ * PARAM: a1 = the semaphore, which must be in kUseg3
+ */
+HIDDEN void sys12_pSemVirt(int asid, int* semAdd) {
+	Bool blocked = FALSE;
+
+	if(whichRegion((memaddr) semAdd) != 3 || !ALIGNED(semAdd))
+		killUProc(asid);
+
+	SYSCALL(PASSEREN, (int) &avslSem, 0, 0);
+	(*semAdd)--;
+	if(*semAdd < 0)
+		blocked = insertVirtBlocked(semAdd, asid);
+	SYSCALL(VERHOGEN, (int) &avslSem, 0, 0);
+
+	if(blocked)
+		SYSCALL(PASSEREN, (int) &(uProcs[asid - 1].u_sem), 0, 0);
+}
+
+/*
+ * Sleeps for at least the given number of seconds; the delay daemon
+ * wakes the U-proc on the first pseudo-clock tick after it is due.
+ *
+ * EX: void SYSCALL (DELAY, int secs)
+ *    Where the mnemonic constant DELAY has the value of 13.
+ * PARAM: a1 = seconds, not negative
+ */
+HIDDEN void sys13_delay(int asid, int secs) {
+	cpu_t now;
+
+	if(secs < 0)
+		killUProc(asid);
+
+	SYSCALL(PASSEREN, (int) &adlSem, 0, 0);
+	STCK(now);
+	insertDelay(asid, now + secs * SECOND); /* one slot per U-proc */
+	SYSCALL(VERHOGEN, (int) &adlSem, 0, 0);
+
+	SYSCALL(PASSEREN, (int) &(uProcs[asid - 1].u_sem), 0, 0);
+}
+
+/*
+ * Writes a page of the U-proc's memory to a disk sector, through the
+ * block cache: the sector reaches the disk when its buffer is reused,
+ * flushed or DISK_FLUSHed. The page is copied into the buffer, as the
+ * U-proc may change it before the buffer is written back. If no buffer
+ * can be had it is written through, noted with writeStarted so no miss
+ * caches what it replaces.
+ *
+ * EX: int SYSCALL (DISK_PUT, int *blockAddr, int diskNo, int sectNo)
+ *    Where the mnemonic constant DISK_PUT has the value of 14.
+ * PARAM: a1 = the page, in kUseg2 or kUseg3
+ *        a2 = disk number, not the backing store's
+ *        a3 = linear sector number
+ * RETURN: v0 = READY, or minus the failed status
+ */
+HIDDEN int sys14_diskPut(int asid, memaddr buf, int disk, int sector) {
+	bcache_PTR b;
+	int status;
+
+	if(disk <= BACKINGDISK || disk >= DEVPERINT || !validUser(buf, PAGESIZE))
+		killUProc(asid);
+
+	if(sector < 0 || sector >= diskSectors(disk))
+		return -DISKSEEKERR;
+
+	SYSCALL(PASSEREN, (int) &cacheSem, 0, 0);
+	b = findBlock(disk, sector);
+	if(b == NULL && (b = claimBlock(disk, sector)) == NULL)
+		b = findBlock(disk, sector);
+	if(b != NULL) {
+		copyPage(buf, b->b_buf);
+		b->b_dirty = TRUE;
+		touchBlock(b);
+		cacheStats.cs_puts++;
+		SYSCALL(VERHOGEN, (int) &cacheSem, 0, 0);
+		return READY;
+	}
+	writeStarted(disk);
+	SYSCALL(VERHOGEN, (int) &cacheSem, 0, 0);
+
+	status = diskUser(asid, buf, disk, sector, DISKWRITE);
+
+	SYSCALL(PASSEREN, (int) &cacheSem, 0, 0);
+	writeDone(disk);
+	SYSCALL(VERHOGEN, (int) &cacheSem, 0, 0);
+
+	return status;
+}
+
+/*
+ * Reads a disk sector into a page of the U-proc's memory, from the
+ * block cache if it holds the sector. A page aligned page is pinned
+ * first, before the cache is taken, as one holding pins may wait on a
+ * busy buffer. A miss claims a buffer for the sector, busy, so a
+ * DISK_PUT of the sector meanwhile waits for it, and reads without
+ * holding the cache: into the pinned frame, then filling the buffer
+ * from it, or into the buffer, then copied to an unaligned page. What
+ * was read is kept only if no write bypassing the cache overlapped the
+ * read. If no buffer can be had the disk is read into the page (see
+ * diskUser). A failed read leaves a page aligned page undefined, any
+ * other as it was.
+ *
+ * EX: int SYSCALL (DISK_GET, int *blockAddr, int diskNo, int sectNo)
+ *    Where the mnemonic constant DISK_GET has the value of 15.
+ * PARAM: a1 = the page, in kUseg2 or kUseg3; kUseg1 kills the U-proc
+ *        a2 = disk number, not the backing store's
+ *        a3 = linear sector number
+ * RETURN: v0 = READY, or minus the failed status
+ */
+HIDDEN int sys15_diskGet(int asid, memaddr buf, int disk, int sector) {
+	bcache_PTR b;
+	memaddr frame = buf;
+	Bool pinned, uncached = FALSE;
+	int status = READY, gen;
+
+	if(disk <= BACKINGDISK || disk >= DEVPERINT || !validUser(buf, PAGESIZE))
+		killUProc(asid);
+
+	pinned = PAGEALIGNED(buf);
+	if(pinned) {
+		reservePins(1);
+		frame = pinUser(asid, buf, TRUE);
+	}
+
+	SYSCALL(PASSEREN, (int) &cacheSem, 0, 0);
+	b = findBlock(disk, sector);
+	if(b == NULL && (b = claimBlock(disk, sector)) != NULL) {
+		cacheStats.cs_misses++;
+		b->b_busy = TRUE;
+		gen = writeGen(disk);
+		SYSCALL(VERHOGEN, (int) &cacheSem, 0, 0);
+
+		status = diskRequest(disk, sector, pinned ? frame : b->b_buf,
+			DISKREAD);
+
+		SYSCALL(PASSEREN, (int) &cacheSem, 0, 0);
+		if(status == READY && pinned)
+			copyPage(frame, b->b_buf);
+		else if(status == READY)
+			copyPage(b->b_buf, buf);
+		if(status == READY && writesQuiet(disk, gen))
+			touchBlock(b);
+		else
+			dropBlock(b);
+		releaseBlock(b);
+	} else {
+		/* Cached while claimBlock wrote a buffer back */
+		if(b == NULL)
+			b = findBlock(disk, sector);
+		if(b != NULL) {
+			copyPage(b->b_buf, frame);
+			touchBlock(b);
+			cacheStats.cs_hits++;
+		} else {
+			cacheStats.cs_misses++;
+			uncached = TRUE;
+		}
+	}
+	SYSCALL(VERHOGEN, (int) &cacheSem, 0, 0);
+
+	if(uncached && pinned)
+		status = diskRequest(disk, sector, frame, DISKREAD);
+	else if(uncached)
+		status = diskUser(asid, buf, disk, sector, DISKREAD);
+	if(pinned)
+		unpinUser(frame);
+
+	return status;
+}
+
+/*
+ * Spools a string as a job for the U-proc's printer. The string is
+ * copied in and the U-proc goes on, blocking only while the spool is
+ * full; WAITPRINTJOB waits for the job to be printed.
+ *
+ * EX: int SYSCALL (WRITEPRINTER, char *virtAddr, int len)
+ *    Where the mnemonic constant WRITEPRINTER has the value of 16.
+ * PARAM: a1 = the string, in kUseg2 or kUseg3
+ *        a2 = its length
+ * RETURN: v0 = the job's id, 0 if the printer is not installed
+ */
+HIDDEN int sys16_writePrinter(int asid, char* str, int len) {
+	int prnt = asid - 1, i = 0, job;
+	int* mutex = &(devMutex[DEVSEMINDEX(PRNTINT, prnt, FALSE)]);
+	spool_t* sp = &(spools[prnt]);
+
+	if(!validUser((memaddr) str, len))
+		killUProc(asid);
+
+	if(!devInstalled(PRNTINT, prnt))
+		return 0;
+
+	SYSCALL(PASSEREN, (int) mutex, 0, 0);
+	while(sp->sp_jobs == SPOOLJOBS) {
+		sp->sp_writers++;
+		SYSCALL(VERHOGEN, (int) mutex, 0, 0);
+		SYSCALL(PASSEREN, (int) &(sp->sp_space), 0, 0);
+		SYSCALL(PASSEREN, (int) mutex, 0, 0);
+	}
+	job = ++sp->sp_lastJob;
+	sp->sp_jobLen[(sp->sp_jobHead + sp->sp_jobs) % SPOOLJOBS] = len;
+	sp->sp_jobs++;
+
+	/* A job longer than the spool is printed while it is copied in */
+	while(TRUE) {
+		while(i < len && sp->sp_count < SPOOLSIZE) {
+			sp->sp_buf[(sp->sp_head + sp->sp_count) % SPOOLSIZE] = str[i++];
+			sp->sp_count++;
+		}
+
+		if(sp->sp_idle) {
+			sp->sp_idle = FALSE;
+			SYSCALL(VERHOGEN, (int) &(sp->sp_work), 0, 0);
+		}
+
+		if(i == len)
+			break;
+		sp->sp_writers++;
+		SYSCALL(VERHOGEN, (int) mutex, 0, 0);
+		SYSCALL(PASSEREN, (int) &(sp->sp_space), 0, 0);
+		SYSCALL(PASSEREN, (int) mutex, 0, 0);
+	}
+	SYSCALL(VERHOGEN, (int) mutex, 0, 0);
+
+	return job;
+}
+
+/*
+ * Reads the TOD clock.
+ *
+ * EX: cpu_t SYSCALL (GET_TOD)
+ *    Where the mnemonic constant GET_TOD has the value of 17.
+ * RETURN: v0 = microseconds since the machine started
+ */
+HIDDEN cpu_t sys17_getTOD() {
+	cpu_t now;
+
+	STCK(now);
+	return now;
+}
+
+/*
+ * Writes a disk's dirty block cache buffers back, for durability.
+ *
+ * EX: int SYSCALL (DISK_FLUSH, int diskNo)
+ *    Where the mnemonic constant DISK_FLUSH has the value of 19.
+ * PARAM: a1 = disk number, not the backing store's
+ * RETURN: v0 = READY, or minus the first failed status
+ */
+HIDDEN int sys19_diskFlush(int asid, int disk) {
+	if(disk <= BACKINGDISK || disk >= DEVPERINT)
+		killUProc(asid);
+
+	return flushCache(disk);
+}
+
+/*
+ * Reads a vector of disk sectors into pages of the U-proc's memory,
+ * blocking once for the lot. A page aligned page whose segment fails
+ * is undefined afterwards (see diskUser).
+ *
+ * EX: int SYSCALL (DISK_GETV, diskvec_t *vec, int count, int diskNo)
+ *    Where the mnemonic constant DISK_GETV has the value of 20.
+ * PARAM: a1 = the vector, in kUseg2 or kUseg3; each segment's page must
+ *             be too, and gets its dv_status set
+ *        a2 = segments, at most MAXDISKVEC
+ *        a3 = disk number, not the backing store's
+ * RETURN: v0 = READY, or minus the first failed segment's status
+ */
+HIDDEN int sys20_diskGetV(int asid, diskvec_t* vec, int count, int disk) {
+	return diskVector(asid, vec, count, disk, DISKREAD);
+}
+
+/*
+ * Writes pages of the U-proc's memory to a vector of disk sectors,
+ * blocking once for the lot. Unlike DISK_PUT the writes are not left
+ * in the block cache; they are done by the time it returns.
+ *
+ * EX: int SYSCALL (DISK_PUTV, diskvec_t *vec, int count, int diskNo)
+ *    Where the mnemonic constant DISK_PUTV has the value of 21.
+ * PARAM: a1 = the vector, in kUseg2 or kUseg3; each segment's page must
+ *             be too, and gets its dv_status set
+ *        a2 = segments, at most MAXDISKVEC
+ *        a3 = disk number, not the backing store's
+ * RETURN: v0 = READY, or minus the first failed segment's status
+ */
+HIDDEN int sys21_diskPutV(int asid, diskvec_t* vec, int count, int disk) {
+	return diskVector(asid, vec, count, disk, DISKWRITE);
+}
+
+/*
+ * Waits until everything the U-proc wrote to its terminal has been
+ * transmitted.
+ *
+ * EX: int SYSCALL (DRAINTERMINAL)
+ *    Where the mnemonic constant DRAINTERMINAL has the value of 22.
+ * RETURN: v0 = READY, or minus the first failed transmit status since
+ *         the last DRAINTERMINAL
+ */
+HIDDEN int sys22_drainTerminal(int asid) {
+	return termDrain(asid - 1);
+}
+
+/*
+ * Waits until a job the U-proc spooled on its printer is printed.
+ *
+ * EX: int SYSCALL (WAITPRINTJOB, int jobId)
+ *    Where the mnemonic constant WAITPRINTJOB has the value of 23.
+ * PARAM: a1 = the id WRITEPRINTER returned, 0 for every job so far
+ * RETURN: v0 = READY, or minus the first failed status since the last
+ *         WAITPRINTJOB
+ */
+HIDDEN int sys23_waitPrintJob(int asid, int job) {
+	if(job < 0 || job > spools[asid - 1].sp_lastJob)
+		killUProc(asid);
+
+	return spoolWait(asid - 1, job);
+}
+
+/*
+ * Copies a disk's scheduler counters (see diskstat_t), so a U-proc can
+ * set the seeks its load cost against the requests served.
+ *
+ * EX: int SYSCALL (DISK_STATS, diskstat_t *stats, int diskNo)
+ *    Where the mnemonic constant DISK_STATS has the value of 24.
+ * PARAM: a1 = where to copy them, in kUseg2 or kUseg3
+ *        a2 = disk number
+ * RETURN: v0 = READY
+ */
+HIDDEN int sys24_diskStats(int asid, diskstat_t* stats, int disk) {
+	diskstat_t* ds;
+
+	if(disk < 0 || disk >= DEVPERINT ||
+		!validUser((memaddr) stats, sizeof(diskstat_t)))
+		killUProc(asid);
+
+	ds = &(diskStats[disk]);
+	stats->ds_requests = ds->ds_requests;
+	stats->ds_merged = ds->ds_merged;
+	stats->ds_seeks = ds->ds_seeks;
+	stats->ds_sumLatency = ds->ds_sumLatency;
+	stats->ds_maxLatency = ds->ds_maxLatency;
+	stats->ds_busy = ds->ds_busy;
+	return READY;
+}
+
+/*
+ * spoolWait - Waits until a printer has printed a job and every job
+ * spooled before it
+ * PARAM: prnt is the printer's device number
+ *        job is the job's id, 0 for the newest
+ * RETURN: READY, or minus the first failed status since the last wait
+ */
+HIDDEN int spoolWait(int prnt, int job) {
+	int* mutex = &(devMutex[DEVSEMINDEX(PRNTINT, prnt, FALSE)]);
+	spool_t* sp = &(spools[prnt]);
+	int status;
+
+	if(!devInstalled(PRNTINT, prnt))
+		return READY;
+
+	SYSCALL(PASSEREN, (int) mutex, 0, 0);
+	if(job == 0)
+		job = sp->sp_lastJob;
+	while(sp->sp_doneJob < job) {
+		sp->sp_waiters++;
+		SYSCALL(VERHOGEN, (int) mutex, 0, 0);
+		SYSCALL(PASSEREN, (int) &(sp->sp_event), 0, 0);
+		SYSCALL(PASSEREN, (int) mutex, 0, 0);
+	}
+	status = sp->sp_status;
+	sp->sp_status = READY;
+	SYSCALL(VERHOGEN, (int) mutex, 0, 0);
+
+	return status;
+}
+
+/*
+ * termWrite - Queues a string on a terminal's transmit ring, blocking
+ * only while the ring is full; the terminal's daemon transmits it
+ * PARAM: term is the terminal's device number
+ *        str, len is the string, already validated
+ * RETURN: len, 0 if the terminal is not installed
+ */
+HIDDEN int termWrite(int term, char* str, int len) {
+	int* mutex = &(devMutex[DEVSEMINDEX(TERMINT, term, FALSE)]);
+	termring_t* ring = &(txRings[term]);
+	int i = 0;
+
+	if(!devInstalled(TERMINT, term))
+		return 0;
+
+	while(i < len) {
+		SYSCALL(PASSEREN, (int) mutex, 0, 0);
+		while(i < len && ring->tr_count < TERMRINGSIZE) {
+			ring->tr_buf[(ring->tr_head + ring->tr_count) % TERMRINGSIZE] =
+				str[i++];
+			ring->tr_count++;
+		}
+
+		if(ring->tr_idle && ring->tr_count > 0) {
+			ring->tr_idle = FALSE;
+			SYSCALL(VERHOGEN, (int) &(ring->tr_work), 0, 0);
+		}
+
+		if(i < len) {
+			ring->tr_writers++;
+			SYSCALL(VERHOGEN, (int) mutex, 0, 0);
+			SYSCALL(PASSEREN, (int) &(ring->tr_space), 0, 0);
+		} else
+			SYSCALL(VERHOGEN, (int) mutex, 0, 0);
+	}
+
+	return len;
+}
+
+/*
+ * termDrain - Waits until a terminal's transmit ring is empty, every
+ * character queued so far transmitted or failed
+ * PARAM: term is the terminal's device number
+ * RETURN: READY, or minus the first failed status since the last drain
+ */
+HIDDEN int termDrain(int term) {
+	int* mutex = &(devMutex[DEVSEMINDEX(TERMINT, term, FALSE)]);
+	termring_t* ring = &(txRings[term]);
+	int status;
+
+	if(!devInstalled(TERMINT, term))
+		return READY;
+
+	SYSCALL(PASSEREN, (int) mutex, 0, 0);
+	if(ring->tr_count > 0) {
+		ring->tr_waiters++;
+		SYSCALL(VERHOGEN, (int) mutex, 0, 0);
+		SYSCALL(PASSEREN, (int) &(ring->tr_event), 0, 0);
+		SYSCALL(PASSEREN, (int) mutex, 0, 0);
+	}
+	status = ring->tr_status;
+	ring->tr_status = READY;
+	SYSCALL(VERHOGEN, (int) mutex, 0, 0);
+
+	return status;
+}
+
+/*
+ * appendField - Appends a label and a non-negative int in decimal
+ * PARAM: line has room for both, len is its length so far
+ * RETURN: the new length
+ */
+HIDDEN int appendField(char* line, int len, char* label, int n) {
+	char digits[12];
+	int count = 0;
+
+	while(*label != EOS)
+		line[len++] = *label++;
+
+	do {
+		digits[count++] = '0' + (n % 10);
+		n /= 10;
+	} while(n > 0);
+
+	while(count > 0)
+		line[len++] = digits[--count];
+
+	return len;
+}